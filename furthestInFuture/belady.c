@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <string.h>
+#include "belady.h"
+
+// Next use of a page that is never requested again; above every index
+#define NEVER UINT32_MAX
+
+struct InternSlot {
+    const char *key;
+    uint32_t len;
+    uint32_t hash;
+    uint32_t id; // UINT32_MAX while the slot is empty
+};
+
+// One cached page: its ID and the index of its next request
+typedef struct {
+    uint32_t next;
+    uint32_t id;
+} HeapEntry;
+
+static uint32_t hashBytes(const char *key, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int allocSlots(Interner *interner, size_t capacity)
+{
+    interner->slots = malloc(capacity * sizeof(struct InternSlot));
+    if (interner->slots == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        interner->slots[i].id = UINT32_MAX;
+    }
+    interner->mask = capacity - 1;
+    return 0;
+}
+
+int internerInit(Interner *interner)
+{
+    interner->count = 0;
+    return allocSlots(interner, 1024);
+}
+
+void internerFree(Interner *interner)
+{
+    free(interner->slots);
+    interner->slots = NULL;
+}
+
+// Doubles the slot array, keeping it at most half full
+static int internerGrow(Interner *interner)
+{
+    struct InternSlot *old = interner->slots;
+    const size_t oldCapacity = interner->mask + 1;
+    if (allocSlots(interner, oldCapacity * 2) != 0) {
+        interner->slots = old;
+        return -1;
+    }
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].id == UINT32_MAX) {
+            continue;
+        }
+        size_t idx = old[i].hash & interner->mask;
+        while (interner->slots[idx].id != UINT32_MAX) {
+            idx = (idx + 1) & interner->mask;
+        }
+        interner->slots[idx] = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+uint32_t internerId(Interner *interner, const char *key, size_t len)
+{
+    const uint32_t hash = hashBytes(key, len);
+    size_t idx = hash & interner->mask;
+
+    // Linear probing
+    while (interner->slots[idx].id != UINT32_MAX) {
+        const struct InternSlot *slot = &interner->slots[idx];
+        if (slot->hash == hash && slot->len == len && memcmp(slot->key, key, len) == 0) {
+            return slot->id;
+        }
+        idx = (idx + 1) & interner->mask;
+    }
+
+    if ((size_t)(interner->count + 1) * 2 > interner->mask + 1) {
+        if (internerGrow(interner) != 0) {
+            return UINT32_MAX;
+        }
+        idx = hash & interner->mask;
+        while (interner->slots[idx].id != UINT32_MAX) {
+            idx = (idx + 1) & interner->mask;
+        }
+    }
+
+    interner->slots[idx] = (struct InternSlot){key, (uint32_t)len, hash, interner->count};
+    return interner->count++;
+}
+
+static int isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+size_t internRequests(Interner *interner, const char *line, size_t len, uint32_t **ids)
+{
+    // Count first so the ID array is allocated once
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isSeparator(line[i]) && (i == 0 || isSeparator(line[i - 1]))) {
+            count++;
+        }
+    }
+
+    *ids = NULL;
+    if (count == 0) {
+        return 0;
+    }
+    *ids = malloc(count * sizeof(uint32_t));
+    if (*ids == NULL) {
+        return (size_t)-1;
+    }
+
+    size_t n = 0;
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && isSeparator(line[i])) {
+            i++;
+        }
+        const size_t start = i;
+        while (i < len && !isSeparator(line[i])) {
+            i++;
+        }
+        if (i > start) {
+            const uint32_t id = internerId(interner, line + start, i - start);
+            if (id == UINT32_MAX) {
+                free(*ids);
+                *ids = NULL;
+                return (size_t)-1;
+            }
+            (*ids)[n++] = id;
+        }
+    }
+    return count;
+}
+
+// Indexed max-heap: pos[id] is where page `id` sits in the heap, or
+// NOT_CACHED, so a hit can update its page in place
+#define NOT_CACHED UINT32_MAX
+
+static void heapSet(HeapEntry *heap, uint32_t *pos, size_t i, HeapEntry entry)
+{
+    heap[i] = entry;
+    pos[entry.id] = (uint32_t)i;
+}
+
+static void siftUp(HeapEntry *heap, uint32_t *pos, size_t i)
+{
+    const HeapEntry entry = heap[i];
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (heap[parent].next >= entry.next) {
+            break;
+        }
+        heapSet(heap, pos, i, heap[parent]);
+        i = parent;
+    }
+    heapSet(heap, pos, i, entry);
+}
+
+static void siftDown(HeapEntry *heap, uint32_t *pos, size_t size, size_t i)
+{
+    const HeapEntry entry = heap[i];
+    while (1) {
+        size_t child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && heap[child + 1].next > heap[child].next) {
+            child++;
+        }
+        if (heap[child].next <= entry.next) {
+            break;
+        }
+        heapSet(heap, pos, i, heap[child]);
+        i = child;
+    }
+    heapSet(heap, pos, i, entry);
+}
+
+long long beladyMisses(const uint32_t *ids, size_t count, uint32_t numIds, int cacheSize)
+{
+    if (cacheSize <= 0) {
+        return (long long)count;
+    }
+    // Request indices are stored in 32 bits, with NEVER reserved
+    if (count >= NEVER) {
+        return -1;
+    }
+
+    uint32_t *next = malloc((count > 0 ? count : 1) * sizeof(uint32_t));
+    uint32_t *pos = malloc((numIds > 0 ? numIds : 1) * sizeof(uint32_t));
+    size_t capacity = (size_t)cacheSize < numIds ? (size_t)cacheSize : numIds;
+    HeapEntry *heap = malloc((capacity > 0 ? capacity : 1) * sizeof(HeapEntry));
+    if (next == NULL || pos == NULL || heap == NULL) {
+        free(next);
+        free(pos);
+        free(heap);
+        return -1;
+    }
+
+    // Next occurrence of each request, walking backwards; pos doubles as
+    // the "last seen" table here
+    for (uint32_t id = 0; id < numIds; id++) {
+        pos[id] = NEVER;
+    }
+    for (size_t r = count; r-- > 0;) {
+        next[r] = pos[ids[r]];
+        pos[ids[r]] = (uint32_t)r;
+    }
+    for (uint32_t id = 0; id < numIds; id++) {
+        pos[id] = NOT_CACHED;
+    }
+
+    size_t size = 0;
+    long long misses = 0;
+    for (size_t r = 0; r < count; r++) {
+        const HeapEntry entry = {next[r], ids[r]};
+        const uint32_t at = pos[entry.id];
+
+        if (at != NOT_CACHED) {
+            // Hit: its next use moves later, towards the root
+            heap[at].next = entry.next;
+            siftUp(heap, pos, at);
+            continue;
+        }
+
+        misses++;
+        if (size < capacity) {
+            heapSet(heap, pos, size, entry);
+            siftUp(heap, pos, size);
+            size++;
+        } else {
+            // Evict the page used furthest in the future (or never again)
+            pos[heap[0].id] = NOT_CACHED;
+            heapSet(heap, pos, 0, entry);
+            siftDown(heap, pos, size, 0);
+        }
+    }
+
+    free(heap);
+    free(pos);
+    free(next);
+    return misses;
+}
@@ -0,0 +1,38 @@
+#ifndef BELADY_H
+#define BELADY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Furthest-in-future (Belady) paging in O(log cacheSize) per request.
+//
+// Requests are interned to dense IDs so the simulation works on integers,
+// the next occurrence of every request is found in one backwards pass (as
+// FurthestInFuture.java does), and the cache is a max-heap keyed by next
+// use, so the page to evict is always at the root.
+
+// Maps request tokens to dense IDs 0, 1, 2, ... in order of first
+// appearance. Keys point into the caller's text, which must outlive it.
+typedef struct {
+    struct InternSlot *slots;
+    size_t mask;
+    uint32_t count;
+} Interner;
+
+int internerInit(Interner *interner);
+void internerFree(Interner *interner);
+// ID of the `len` bytes at `key`, adding it if new; UINT32_MAX if out of
+// memory
+uint32_t internerId(Interner *interner, const char *key, size_t len);
+
+// Splits `line` on spaces and tabs and interns each token. Returns the
+// number of requests and the malloc'd ID array in *ids (NULL for none),
+// or (size_t)-1 if out of memory.
+size_t internRequests(Interner *interner, const char *line, size_t len, uint32_t **ids);
+
+// Page faults serving ids[0..count) through a cache of cacheSize pages.
+// IDs must be below numIds and count below 2^32 - 1. Returns -1 if out of
+// memory or the trace is too long.
+long long beladyMisses(const uint32_t *ids, size_t count, uint32_t numIds, int cacheSize);
+
+#endif
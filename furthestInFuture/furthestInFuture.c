@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "belady.h"
+
+// Description: Native Furthest in Future paging policy, same input and
+// output as FurthestInFuture.java but O(log cacheSize) per request
+// Input (stdin, or the file named on the command line):
+//  int instances
+//  int cache size
+//  int number of page requests (ignored; the request line is read whole)
+//  requests delimited by spaces; any tokens, not just integers
+// Output:
+//  Number of page faults per instance
+
+typedef struct {
+    char *data;
+    size_t size;
+    int mapped;
+} Input;
+
+// Maps regular files; reads pipes into one growing buffer
+static int readInput(Input *input, int fd)
+{
+    struct stat info;
+    input->data = NULL;
+    input->size = 0;
+    input->mapped = 0;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        input->data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (input->data != MAP_FAILED) {
+            posix_madvise(input->data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+            input->size = (size_t)info.st_size;
+            input->mapped = 1;
+            return 0;
+        }
+        input->data = NULL;
+    }
+
+    size_t capacity = 0;
+    while (1) {
+        if (input->size == capacity) {
+            capacity = capacity ? capacity * 2 : 1 << 20;
+            char *grown = realloc(input->data, capacity);
+            if (grown == NULL) {
+                fprintf(stderr, "Error: out of memory reading input\n");
+                free(input->data);
+                return -1;
+            }
+            input->data = grown;
+        }
+        const ssize_t got = read(fd, input->data + input->size, capacity - input->size);
+        if (got < 0) {
+            perror("read");
+            free(input->data);
+            return -1;
+        }
+        if (got == 0) {
+            return 0;
+        }
+        input->size += (size_t)got;
+    }
+}
+
+static void freeInput(Input *input)
+{
+    if (input->mapped) {
+        munmap(input->data, input->size);
+    } else {
+        free(input->data);
+    }
+}
+
+// The line starting at *cursor, without its line ending; advances past it.
+// Returns 0 at the end of the input.
+static int nextLine(const char **cursor, const char *end, const char **line, size_t *len)
+{
+    const char *p = *cursor;
+    if (p >= end) {
+        return 0;
+    }
+    const char *stop = p;
+    while (stop < end && *stop != '\n') {
+        stop++;
+    }
+    *line = p;
+    *len = (size_t)(stop - p);
+    if (*len > 0 && p[*len - 1] == '\r') {
+        (*len)--;
+    }
+    *cursor = stop < end ? stop + 1 : end;
+    return 1;
+}
+
+// Like Scanner.nextInt() then nextLine(): the next integer, skipping blank
+// lines, and the rest of its line. Returns 0 if there is none.
+static int nextInt(const char **cursor, const char *end, long *value)
+{
+    const char *line;
+    size_t len;
+    while (nextLine(cursor, end, &line, &len)) {
+        char buffer[32];
+        size_t i = 0;
+        while (i < len && (line[i] == ' ' || line[i] == '\t')) {
+            i++;
+        }
+        if (i == len) {
+            continue;
+        }
+        size_t n = 0;
+        while (i < len && n + 1 < sizeof(buffer) && line[i] != ' ' && line[i] != '\t') {
+            buffer[n++] = line[i++];
+        }
+        buffer[n] = '\0';
+        char *parsed;
+        *value = strtol(buffer, &parsed, 10);
+        return n > 0 && *parsed == '\0';
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int fd = STDIN_FILENO;
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [requests file]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2) {
+        fd = open(argv[1], O_RDONLY);
+        if (fd < 0) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    Input input;
+    const int failed = readInput(&input, fd);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    if (failed) {
+        return 1;
+    }
+
+    const char *cursor = input.data;
+    const char *end = input.data + input.size;
+    long numInstances;
+    if (!nextInt(&cursor, end, &numInstances)) {
+        fprintf(stderr, "Error: expected the number of instances\n");
+        freeInput(&input);
+        return 1;
+    }
+
+    int status = 0;
+    for (long i = 0; i < numInstances; i++) {
+        long cacheSize;
+        const char *line;
+        size_t len;
+        // Cache size, then the request count line, then the requests
+        if (!nextInt(&cursor, end, &cacheSize) || !nextLine(&cursor, end, &line, &len) ||
+            !nextLine(&cursor, end, &line, &len)) {
+            fprintf(stderr, "Error: instance %ld is incomplete\n", i + 1);
+            status = 1;
+            break;
+        }
+
+        Interner interner;
+        uint32_t *ids = NULL;
+        size_t count = (size_t)-1;
+        if (internerInit(&interner) == 0) {
+            count = internRequests(&interner, line, len, &ids);
+        }
+        const long long misses = count == (size_t)-1
+                                     ? -1
+                                     : beladyMisses(ids, count, interner.count,
+                                                    cacheSize > INT32_MAX ? INT32_MAX : (int)cacheSize);
+        free(ids);
+        internerFree(&interner);
+        if (misses < 0) {
+            fprintf(stderr, "Error: instance %ld: out of memory or too many requests\n", i + 1);
+            status = 1;
+            break;
+        }
+        printf("%lld\n", misses);
+    }
+
+    freeInput(&input);
+    return status;
+}
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "belady.h"
+
+// Checks the heap-based simulator against a direct port of the eviction
+// scan in FurthestInFuture.java
+
+static int failures = 0;
+
+static void printTestResult(const char *description, int passed)
+{
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+    if (!passed) {
+        failures++;
+    }
+}
+
+static unsigned long long nextRand(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// FurthestInFuture.java on interned IDs: lastSeen holds each page's next
+// use, and a miss with a full cache scans the cache list for the page used
+// furthest in the future, taking the first one never used again
+static long long referenceMisses(const uint32_t *ids, size_t count, uint32_t numIds, int cacheSize)
+{
+    int *nextOccurrences = malloc(count * sizeof(int));
+    int *lastSeen = malloc(numIds * sizeof(int));
+    char *cached = calloc(numIds, 1);
+    uint32_t *cacheList = malloc((size_t)cacheSize * sizeof(uint32_t));
+    int cacheUsed = 0;
+    long long misses = 0;
+
+    for (uint32_t id = 0; id < numIds; id++) {
+        lastSeen[id] = -1;
+    }
+    for (size_t r = count; r-- > 0;) {
+        nextOccurrences[r] = lastSeen[ids[r]];
+        lastSeen[ids[r]] = (int)r;
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        if (!cached[ids[r]]) {
+            if (cacheUsed == cacheSize) {
+                int indexToRemove = -1;
+                int maxFar = -1;
+                for (int c = 0; c < cacheUsed; c++) {
+                    const int nextOccur = lastSeen[cacheList[c]];
+                    if (nextOccur == -1) {
+                        indexToRemove = c;
+                        break;
+                    }
+                    if (nextOccur > maxFar) {
+                        maxFar = nextOccur;
+                        indexToRemove = c;
+                    }
+                }
+                cached[cacheList[indexToRemove]] = 0;
+                cacheList[indexToRemove] = ids[r];
+            } else {
+                cacheList[cacheUsed++] = ids[r];
+            }
+            cached[ids[r]] = 1;
+            misses++;
+        }
+        lastSeen[ids[r]] = nextOccurrences[r];
+    }
+
+    free(cacheList);
+    free(cached);
+    free(lastSeen);
+    free(nextOccurrences);
+    return misses;
+}
+
+static void testInterning(void)
+{
+    const char line[] = "12 3 33\t14 12  20 12 3 14 33 12 20\r";
+    const uint32_t expected[] = {0, 1, 2, 3, 0, 4, 0, 1, 3, 2, 0, 4};
+    Interner interner;
+    uint32_t *ids = NULL;
+    size_t count = 0;
+
+    if (internerInit(&interner) == 0) {
+        count = internRequests(&interner, line, strlen(line), &ids);
+    }
+    printTestResult("Tokens interned in order of first appearance",
+                    count == 12 && interner.count == 5 && memcmp(ids, expected, sizeof(expected)) == 0);
+    printTestResult("Example trace from test1.txt: 6 misses with 4 pages",
+                    count == 12 && beladyMisses(ids, count, interner.count, 4) == 6);
+    free(ids);
+    internerFree(&interner);
+
+    // Enough distinct tokens to grow the table several times
+    char *many = malloc(100000 * 8);
+    size_t len = 0;
+    for (int i = 0; i < 100000; i++) {
+        len += (size_t)sprintf(many + len, "%d ", i % 50000);
+    }
+    int ok = internerInit(&interner) == 0 && internRequests(&interner, many, len, &ids) == 100000 &&
+             interner.count == 50000;
+    for (int i = 0; ok && i < 100000; i++) {
+        ok = ids[i] == (uint32_t)(i % 50000);
+    }
+    printTestResult("50000 distinct tokens survive table growth", ok);
+    free(ids);
+    internerFree(&interner);
+    free(many);
+}
+
+static void testAgainstReference(void)
+{
+    unsigned long long state = 0x9e3779b97f4a7c15ULL;
+    uint32_t *ids = malloc(5000 * sizeof(uint32_t));
+    int mismatches = 0;
+    int traces = 0;
+
+    for (int t = 0; t < 2000; t++) {
+        const size_t count = 1 + nextRand(&state) % 5000;
+        const uint32_t numIds = 1 + nextRand(&state) % 300;
+        const int cacheSize = 1 + (int)(nextRand(&state) % 64);
+        // Mix uniform requests with a hot set so both hits and evictions
+        // are common
+        for (size_t r = 0; r < count; r++) {
+            const unsigned long long x = nextRand(&state);
+            ids[r] = (uint32_t)(x % 4 == 0 ? x % numIds : (x >> 8) % (numIds / 8 + 1));
+        }
+        if (beladyMisses(ids, count, numIds, cacheSize) != referenceMisses(ids, count, numIds, cacheSize)) {
+            mismatches++;
+        }
+        traces++;
+    }
+
+    char description[96];
+    sprintf(description, "%d random traces match the Java eviction scan: %d mismatches", traces, mismatches);
+    printTestResult(description, mismatches == 0);
+
+    printTestResult("Empty trace has no misses", beladyMisses(ids, 0, 0, 4) == 0);
+    printTestResult("Cache of 0 pages misses every request", beladyMisses(ids, 100, 300, 0) == 100);
+    free(ids);
+}
+
+int main(void)
+{
+    testInterning();
+    testAgainstReference();
+
+    printf("\n%s\n", failures == 0 ? "All tests passed" : "Some tests FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+
+// ht_search_batch vs. a loop of ht_search on a table bigger than L3.
+// Links against either table layout.
+// Usage: bench_batch [num_items] [num_lookups] [batch_size]
+
+#define KEY_LEN 24
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char* argv[]) {
+    const int num_items = argc > 1 ? atoi(argv[1]) : 4000000;
+    const int num_lookups = argc > 2 ? atoi(argv[2]) : 4000000;
+    const int batch_size = argc > 3 ? atoi(argv[3]) : 32;
+
+    char (*keys)[KEY_LEN] = malloc((size_t)num_items * KEY_LEN);
+    const char** lookups = malloc((size_t)num_lookups * sizeof(char*));
+    char** results = malloc((size_t)num_lookups * sizeof(char*));
+    if (keys == NULL || lookups == NULL || results == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < num_items; i++) {
+        sprintf(keys[i], "key_%d", i);
+        ht_insert(ht, keys[i], "value");
+    }
+
+    unsigned long long state = 88172645463325252ull;
+    for (int i = 0; i < num_lookups; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        lookups[i] = keys[state % (unsigned long long)num_items];
+    }
+
+    long found = 0;
+    double start = now_sec();
+    for (int i = 0; i < num_lookups; i++) {
+        results[i] = ht_search(ht, lookups[i]);
+    }
+    const double single_sec = now_sec() - start;
+    for (int i = 0; i < num_lookups; i++) found += results[i] != NULL;
+
+    start = now_sec();
+    for (int i = 0; i < num_lookups; i += batch_size) {
+        const int n = num_lookups - i < batch_size ? num_lookups - i : batch_size;
+        ht_search_batch(ht, lookups + i, n, results + i);
+    }
+    const double batch_sec = now_sec() - start;
+    for (int i = 0; i < num_lookups; i++) found += results[i] != NULL;
+
+    printf("items=%d lookups=%d batch=%d found=%ld\n", num_items, num_lookups, batch_size, found);
+    printf("  ht_search loop:   %6.1f ns/lookup\n", single_sec * 1e9 / num_lookups);
+    printf("  ht_search_batch:  %6.1f ns/lookup (%.2fx)\n", batch_sec * 1e9 / num_lookups,
+           single_sec / batch_sec);
+
+    ht_del_hash_table(ht);
+    free(keys);
+    free(lookups);
+    free(results);
+    return found == 2L * num_lookups ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "hash_table.h"
+#include "hash_table_concurrent.h"
+
+// Throughput vs. thread count: one global mutex around ht_hash_table (what
+// callers do today) against the segmented concurrent table.
+// Usage: bench_concurrent [num_keys] [ops_per_thread] [max_threads]
+// Workload is 95% searches, 5% inserts over a preloaded key set.
+
+typedef struct {
+    int id;
+    int num_keys;
+    int ops;
+    int use_concurrent;
+} bench_arg_t;
+
+static ht_hash_table* global_ht;
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static ht_concurrent_table* concurrent_ht;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *bench_worker(void *arg) {
+    bench_arg_t *args = arg;
+    unsigned long long state = 0x9e3779b97f4a7c15ull * (unsigned long long)(args->id + 1);
+    char key[64], out[32];
+
+    for (int i = 0; i < args->ops; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        sprintf(key, "https://example.com/session/%llu", state % (unsigned long long)args->num_keys);
+        const int is_write = (state >> 40) % 100 < 5;
+
+        if (args->use_concurrent) {
+            if (is_write) ht_concurrent_insert(concurrent_ht, key, "value");
+            else ht_concurrent_search(concurrent_ht, key, out, sizeof(out), NULL);
+        } else {
+            pthread_mutex_lock(&global_lock);
+            if (is_write) ht_insert(global_ht, key, "value");
+            else ht_search(global_ht, key);
+            pthread_mutex_unlock(&global_lock);
+        }
+    }
+    return NULL;
+}
+
+static double run(int num_threads, int num_keys, int ops, int use_concurrent) {
+    pthread_t threads[64];
+    bench_arg_t args[64];
+
+    const double start = now_sec();
+    for (int i = 0; i < num_threads; i++) {
+        args[i] = (bench_arg_t){i, num_keys, ops, use_concurrent};
+        pthread_create(&threads[i], NULL, bench_worker, &args[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return (double)num_threads * ops / (now_sec() - start);
+}
+
+int main(int argc, char* argv[]) {
+    const int num_keys = argc > 1 ? atoi(argv[1]) : 200000;
+    const int ops = argc > 2 ? atoi(argv[2]) : 500000;
+    int max_threads = argc > 3 ? atoi(argv[3]) : 8;
+    if (max_threads > 64) max_threads = 64;
+
+    global_ht = ht_new();
+    concurrent_ht = ht_concurrent_new();
+    if (global_ht == NULL || concurrent_ht == NULL) {
+        return 1;
+    }
+
+    char key[64];
+    for (int i = 0; i < num_keys; i++) {
+        sprintf(key, "https://example.com/session/%d", i);
+        ht_insert(global_ht, key, "value");
+        ht_concurrent_insert(concurrent_ht, key, "value");
+    }
+
+    printf("keys=%d ops/thread=%d (95%% search, 5%% insert)\n", num_keys, ops);
+    printf("threads,global_mutex_mops,concurrent_mops\n");
+    for (int t = 1; t <= max_threads; t *= 2) {
+        const double global = run(t, num_keys, ops, 0);
+        const double concurrent = run(t, num_keys, ops, 1);
+        printf("%d,%.2f,%.2f\n", t, global / 1e6, concurrent / 1e6);
+    }
+
+    ht_del_hash_table(global_ht);
+    ht_concurrent_del_hash_table(concurrent_ht);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+
+// Per-insert latency with stop-the-world vs. progressive resize, then
+// per-operation latency while every key is deleted and re-inserted, which
+// leaves enough dead storage behind to trigger a compaction.
+// Usage: bench_latency [num_items]
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_double(const void* a, const void* b) {
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int n, double p) {
+    int idx = (int)(p * (n - 1));
+    return sorted[idx];
+}
+
+static void report(const char* name, int num_items, double* latencies) {
+    qsort(latencies, (size_t)num_items, sizeof(double), compare_double);
+    printf("%-12s p50=%7.0f ns  p99=%7.0f ns  p999=%8.0f ns  max=%11.0f ns\n", name,
+           percentile(latencies, num_items, 0.50),
+           percentile(latencies, num_items, 0.99),
+           percentile(latencies, num_items, 0.999),
+           latencies[num_items - 1]);
+}
+
+static void run(const char* name, ht_hash_table* ht, int num_items, double* latencies) {
+    char key[64];
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "https://example.com/session/%d", i);
+        const double start = now_ns();
+        ht_insert(ht, key, "value");
+        latencies[i] = now_ns() - start;
+    }
+    report(name, num_items, latencies);
+}
+
+// Deletes and re-inserts every key in turn. Count stays put, so there is no
+// resize, but by halfway the dead bytes outweigh the live ones.
+static void run_churn(const char* name, ht_hash_table* ht, int num_items, double* latencies) {
+    char key[64];
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "https://example.com/session/%d", i);
+        double start = now_ns();
+        ht_delete(ht, key);
+        latencies[2 * i] = now_ns() - start;
+        start = now_ns();
+        ht_insert(ht, key, "value");
+        latencies[2 * i + 1] = now_ns() - start;
+    }
+    report(name, 2 * num_items, latencies);
+}
+
+int main(int argc, char* argv[]) {
+    const int num_items = argc > 1 ? atoi(argv[1]) : 1000000;
+    double* latencies = malloc(2 * (size_t)num_items * sizeof(double));
+    if (latencies == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+
+    ht_hash_table* blocking = ht_new();
+    ht_hash_table* incremental = ht_new_incremental();
+    if (blocking == NULL || incremental == NULL) return 1;
+
+    printf("inserts=%d\n", num_items);
+    run("blocking", blocking, num_items, latencies);
+    run("incremental", incremental, num_items, latencies);
+
+    printf("delete+insert churn, ops=%d\n", 2 * num_items);
+    run_churn("blocking", blocking, num_items, latencies);
+    run_churn("incremental", incremental, num_items, latencies);
+
+    ht_del_hash_table(blocking);
+    ht_del_hash_table(incremental);
+
+    free(latencies);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+
+// Lookup benchmark. Links against either hash_table.c or hash_table_flat.c,
+// so the same binary source measures both layouts.
+// Usage: bench_lookup [num_items] [num_lookups]
+
+#define KEY_LEN 96
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// URL-like keys, the workload the table is tuned for
+static void make_key(char* buf, int i) {
+    sprintf(buf, "https://example.com/api/v1/resources/collection/items/%d?include=details", i);
+}
+
+// xorshift so runs are repeatable without depending on rand()
+static unsigned long long next_rand(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char* argv[]) {
+    const int num_items = argc > 1 ? atoi(argv[1]) : 1000000;
+    const int num_lookups = argc > 2 ? atoi(argv[2]) : 2000000;
+
+    char (*keys)[KEY_LEN] = malloc((size_t)num_items * KEY_LEN);
+    int* order = malloc((size_t)num_lookups * sizeof(int));
+    if (keys == NULL || order == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        return 1;
+    }
+
+    for (int i = 0; i < num_items; i++) {
+        make_key(keys[i], i);
+    }
+
+    double start = now_sec();
+    for (int i = 0; i < num_items; i++) {
+        ht_insert(ht, keys[i], "value");
+    }
+    const double insert_sec = now_sec() - start;
+
+    unsigned long long state = 88172645463325252ull;
+    for (int i = 0; i < num_lookups; i++) {
+        order[i] = (int)(next_rand(&state) % (unsigned long long)num_items);
+    }
+
+    long found = 0;
+    start = now_sec();
+    for (int i = 0; i < num_lookups; i++) {
+        found += ht_search(ht, keys[order[i]]) != NULL;
+    }
+    const double hit_sec = now_sec() - start;
+
+    // Misses: same shape of key, indices past the inserted range
+    char miss_key[KEY_LEN];
+    start = now_sec();
+    for (int i = 0; i < num_lookups; i++) {
+        make_key(miss_key, num_items + order[i]);
+        found += ht_search(ht, miss_key) != NULL;
+    }
+    const double miss_sec = now_sec() - start;
+
+    printf("items=%d size=%d lookups=%d found=%ld\n", num_items, ht->size, num_lookups, found);
+    printf("  insert:     %8.1f ns/op\n", insert_sec * 1e9 / num_items);
+    printf("  search hit: %8.1f ns/op\n", hit_sec * 1e9 / num_lookups);
+    printf("  search miss:%8.1f ns/op (includes key formatting)\n", miss_sec * 1e9 / num_lookups);
+
+    ht_del_hash_table(ht);
+    free(keys);
+    free(order);
+    return found == num_lookups ? 0 : 1;
+}
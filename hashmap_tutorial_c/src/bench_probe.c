@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "prime.h"
+
+// Cost of turning a hash into bucket indices, with no table memory touched:
+// the `%`-per-attempt double hashing the table used to do, against the
+// fastmod start/step plus add-and-wrap walk it does now. Both produce the
+// same buckets, which the benchmark checks.
+// Usage: bench_probe [num_hashes] [probes_per_hash]
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// xorshift so runs are repeatable without depending on rand()
+static unsigned long long next_rand(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// The previous ht_get_hash
+static int get_hash_mod(const uint64_t hash, const int num_buckets, const int attempt) {
+    const uint64_t hash_a = (hash >> 32) % (uint64_t)num_buckets;
+    uint64_t hash_b = (hash & 0xffffffffu) % (uint64_t)num_buckets;
+    if (hash_b == 0)
+        hash_b = 1;
+    return (int)((hash_a + (uint64_t)attempt * hash_b) % (uint64_t)num_buckets);
+}
+
+int main(int argc, char* argv[]) {
+    const int num_hashes = argc > 1 ? atoi(argv[1]) : 2000000;
+    const int probes = argc > 2 ? atoi(argv[2]) : 4;
+    const int base_sizes[] = {53, 6784, 868352, 111149056};
+
+    uint64_t* hashes = malloc((size_t)num_hashes * sizeof(uint64_t));
+    if (hashes == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+    unsigned long long state = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < num_hashes; i++) {
+        hashes[i] = next_rand(&state);
+    }
+
+    printf("hashes=%d probes/hash=%d\n", num_hashes, probes);
+    printf("%12s %16s %16s %8s\n", "buckets", "% ns/probe", "fastmod ns/probe", "speedup");
+    for (size_t s = 0; s < sizeof(base_sizes) / sizeof(base_sizes[0]); s++) {
+        uint64_t magic;
+        const int size = prime_bucket_count(base_sizes[s], &magic);
+
+        double start = now_sec();
+        uint64_t sum_mod = 0;
+        for (int i = 0; i < num_hashes; i++) {
+            for (int a = 0; a < probes; a++) {
+                sum_mod += (uint64_t)get_hash_mod(hashes[i], size, a);
+            }
+        }
+        const double mod_ns = (now_sec() - start) * 1e9 / ((double)num_hashes * probes);
+
+        start = now_sec();
+        uint64_t sum_fast = 0;
+        for (int i = 0; i < num_hashes; i++) {
+            uint32_t idx = fastmod((uint32_t)(hashes[i] >> 32), magic, (uint32_t)size);
+            uint32_t step = fastmod((uint32_t)hashes[i], magic, (uint32_t)size);
+            if (step == 0) step = 1;
+            for (int a = 0; a < probes; a++) {
+                sum_fast += idx;
+                idx += step;
+                if (idx >= (uint32_t)size) idx -= (uint32_t)size;
+            }
+        }
+        const double fast_ns = (now_sec() - start) * 1e9 / ((double)num_hashes * probes);
+
+        printf("%12d %16.2f %16.2f %7.1fx%s\n", size, mod_ns, fast_ns, mod_ns / fast_ns,
+               sum_mod == sum_fast ? "" : "  MISMATCH");
+    }
+
+    free(hashes);
+    return 0;
+}
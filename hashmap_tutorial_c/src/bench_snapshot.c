@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+
+// Startup cost: rebuilding a table by inserting every entry vs. saving it
+// once and mapping the snapshot back.
+// Usage: bench_snapshot [num_items] [path]
+
+#define KEY_LEN 96
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void make_key(char* buf, int i) {
+    sprintf(buf, "https://example.com/api/v1/resources/collection/items/%d?include=details", i);
+}
+
+int main(int argc, char* argv[]) {
+    const int num_items = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* path = argc > 2 ? argv[2] : "build/bench_snapshot.bin";
+    const int num_lookups = 1000;
+
+    char (*keys)[KEY_LEN] = malloc((size_t)num_items * KEY_LEN);
+    if (keys == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+    for (int i = 0; i < num_items; i++) {
+        make_key(keys[i], i);
+    }
+
+    double start = now_sec();
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < num_items; i++) {
+        ht_insert(ht, keys[i], "value");
+    }
+    const double rebuild_sec = now_sec() - start;
+
+    start = now_sec();
+    if (ht_save(ht, path) != 0) {
+        return 1;
+    }
+    const double save_sec = now_sec() - start;
+    ht_del_hash_table(ht);
+
+    start = now_sec();
+    ht_hash_table* mapped = ht_open_mmap(path);
+    if (mapped == NULL) {
+        return 1;
+    }
+    const double open_sec = now_sec() - start;
+
+    // First lookups pay the page faults the rebuild paid up front
+    long found = 0;
+    start = now_sec();
+    for (int i = 0; i < num_lookups; i++) {
+        found += ht_search(mapped, keys[(long)i * 7919 % num_items]) != NULL;
+    }
+    const double first_sec = now_sec() - start;
+
+    printf("items=%d size=%d found=%ld/%d\n", num_items, mapped->size, found, num_lookups);
+    printf("  rebuild by insert: %10.2f ms\n", rebuild_sec * 1e3);
+    printf("  ht_save:           %10.2f ms (one-off)\n", save_sec * 1e3);
+    printf("  ht_open_mmap:      %10.3f ms\n", open_sec * 1e3);
+    printf("  first %d lookups: %10.3f ms\n", num_lookups, first_sec * 1e3);
+
+    ht_del_hash_table(mapped);
+    remove(path);
+    free(keys);
+    return found == num_lookups ? 0 : 1;
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hash_table.h"
+
+// Benchmark suite behind `make bench`. Links against either hash_table.c or
+// hash_table_flat.c (BENCH_LAYOUT names which one in the output) and writes
+// one row per (layout, key distribution, scenario, size, operation):
+//
+//   fill: insert / search_hit / search_miss / delete throughput and latency
+//         percentiles for a table grown to n entries
+//   load: search_hit / search_miss on a table of at most n entries, measured
+//         as it fills through fixed load factors without resizing
+//
+// Throughput comes from untimed loops; percentiles come from a second pass
+// that times every operation, so they include the clock_gettime overhead
+// (~20-30 ns). Progress goes to stderr, results to stdout or --out.
+//
+// Usage: bench_suite [--sizes 1000,10000,...] [--keys short,url,mixed]
+//                    [--lookups N] [--format csv|json] [--out PATH]
+
+#ifndef BENCH_LAYOUT
+#define BENCH_LAYOUT "pointer"
+#endif
+
+#define MAX_SIZES 16
+#define MIN_OPS 1000000       // repeat builds of small tables up to this many ops
+#define MAX_SAMPLES 200000    // individually timed lookups per row
+
+static const double load_targets[] = {0.40, 0.50, 0.60, 0.70, 0.80};
+#define NUM_LOADS (int)(sizeof(load_targets) / sizeof(load_targets[0]))
+
+typedef enum {KEYS_SHORT, KEYS_URL, KEYS_MIXED, NUM_KEY_KINDS} key_kind;
+static const char* key_kind_names[NUM_KEY_KINDS] = {"short", "url", "mixed"};
+
+typedef struct {
+    char* blob;
+    char** keys;
+    int n;
+} key_set;
+
+typedef struct {
+    FILE* out;
+    int json;
+    int rows;
+} writer;
+
+typedef struct {
+    const char* keys;
+    const char* scenario;
+    int n;
+    int capacity;
+    double load;
+} row_info;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// xorshift so runs are repeatable without depending on rand()
+static unsigned long long next_rand(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int compare_double(const void* a, const void* b) {
+    const double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int n, double p) {
+    return sorted[(int)(p * (n - 1))];
+}
+
+// Writes key `i` into `buf`: a base-62 id that keeps keys unique, then
+// filler up to a length drawn from the distribution. `prefix` is '~' for
+// miss keys so they can never equal an inserted key.
+static int make_key(char* buf, key_kind kind, int i, char prefix, unsigned long long* state) {
+    static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    if (kind == KEYS_URL) {
+        return sprintf(buf, "https://example.com/api/v1/resources/%s%d?include=details",
+                       prefix ? "~" : "", i);
+    }
+
+    int len = 0;
+    if (prefix) buf[len++] = prefix;
+    do {
+        buf[len++] = digits[i % 62];
+        i /= 62;
+    } while (i > 0);
+    buf[len++] = ':';
+
+    const int target = kind == KEYS_SHORT ? 8 + (int)(next_rand(state) % 9)
+                                          : 6 + (int)(next_rand(state) % 123);
+    while (len < target) {
+        buf[len++] = (char)('a' + next_rand(state) % 26);
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// Two passes over the same seed: one to size the blob, one to fill it
+static int key_set_init(key_set* set, key_kind kind, int n, char prefix, unsigned long long seed) {
+    char buf[160];
+    unsigned long long state = seed;
+    size_t total = 0;
+    for (int i = 0; i < n; i++) {
+        total += (size_t)make_key(buf, kind, i, prefix, &state) + 1;
+    }
+
+    set->n = n;
+    set->blob = malloc(total);
+    set->keys = malloc((size_t)n * sizeof(char*));
+    if (set->blob == NULL || set->keys == NULL) {
+        fprintf(stderr, "Error: allocation failed for %d keys\n", n);
+        free(set->blob);
+        free(set->keys);
+        return -1;
+    }
+
+    state = seed;
+    size_t offset = 0;
+    for (int i = 0; i < n; i++) {
+        set->keys[i] = set->blob + offset;
+        offset += (size_t)make_key(set->blob + offset, kind, i, prefix, &state) + 1;
+    }
+    return 0;
+}
+
+static void key_set_free(key_set* set) {
+    free(set->blob);
+    free(set->keys);
+}
+
+static void write_header(writer* w) {
+    if (w->json) {
+        fprintf(w->out, "[\n");
+    } else {
+        fprintf(w->out, "layout,keys,scenario,n,capacity,load,op,ops,mops,ns_per_op,"
+                        "p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+    }
+}
+
+static void write_footer(writer* w) {
+    if (w->json) {
+        fprintf(w->out, "\n]\n");
+    }
+}
+
+// Sorts `latencies` in place
+static void write_row(writer* w, const row_info* info, const char* op, long ops,
+                      double total_ns, double* latencies, int num_latencies) {
+    qsort(latencies, (size_t)num_latencies, sizeof(double), compare_double);
+    const double ns_per_op = total_ns / ops;
+    const double p50 = percentile(latencies, num_latencies, 0.50);
+    const double p90 = percentile(latencies, num_latencies, 0.90);
+    const double p99 = percentile(latencies, num_latencies, 0.99);
+    const double p999 = percentile(latencies, num_latencies, 0.999);
+    const double max = latencies[num_latencies - 1];
+
+    if (w->json) {
+        fprintf(w->out, "%s  {\"layout\": \"%s\", \"keys\": \"%s\", \"scenario\": \"%s\", "
+                        "\"n\": %d, \"capacity\": %d, \"load\": %.3f, \"op\": \"%s\", "
+                        "\"ops\": %ld, \"mops\": %.3f, \"ns_per_op\": %.1f, "
+                        "\"p50_ns\": %.0f, \"p90_ns\": %.0f, \"p99_ns\": %.0f, "
+                        "\"p999_ns\": %.0f, \"max_ns\": %.0f}",
+                w->rows ? ",\n" : "", BENCH_LAYOUT, info->keys, info->scenario,
+                info->n, info->capacity, info->load, op, ops, 1e3 / ns_per_op, ns_per_op,
+                p50, p90, p99, p999, max);
+    } else {
+        fprintf(w->out, "%s,%s,%s,%d,%d,%.3f,%s,%ld,%.3f,%.1f,%.0f,%.0f,%.0f,%.0f,%.0f\n",
+                BENCH_LAYOUT, info->keys, info->scenario, info->n, info->capacity,
+                info->load, op, ops, 1e3 / ns_per_op, ns_per_op, p50, p90, p99, p999, max);
+    }
+    fflush(w->out);
+    w->rows++;
+}
+
+// Random lookups into the first `n` keys of `keys`, throughput then latency.
+// `expect_found` says whether they are hits or misses. Misses draw from as
+// many keys as hits so both touch the same amount of key memory.
+static void bench_search(writer* w, const row_info* info, ht_hash_table* ht, const key_set* keys,
+                         int n, int expect_found, int lookups, const int* order, double* latencies) {
+    long found = 0;
+
+    double start = now_ns();
+    for (int i = 0; i < lookups; i++) {
+        found += ht_search(ht, keys->keys[order[i] % n]) != NULL;
+    }
+    const double total = now_ns() - start;
+
+    const int samples = lookups < MAX_SAMPLES ? lookups : MAX_SAMPLES;
+    for (int i = 0; i < samples; i++) {
+        const char* key = keys->keys[order[i] % n];
+        start = now_ns();
+        found += ht_search(ht, key) != NULL;
+        latencies[i] = now_ns() - start;
+    }
+
+    if (found != (expect_found ? (long)lookups + samples : 0)) {
+        fprintf(stderr, "Error: %s lookups found %ld of %d\n", info->scenario, found, lookups + samples);
+    }
+    write_row(w, info, expect_found ? "search_hit" : "search_miss", lookups, total, latencies, samples);
+}
+
+static void bench_fill(writer* w, key_kind kind, const key_set* keys, const key_set* misses,
+                       int n, int lookups, const int* order, double* latencies) {
+    row_info info = {key_kind_names[kind], "fill", n, 0, 0.0};
+    const int reps = n < MIN_OPS ? MIN_OPS / n : 1;
+    double insert_ns = 0, delete_ns = 0;
+
+    for (int rep = 0; rep < reps; rep++) {
+        ht_hash_table* ht = ht_new();
+        if (ht == NULL) return;
+
+        double start = now_ns();
+        for (int i = 0; i < n; i++) {
+            ht_insert(ht, keys->keys[i], "value");
+        }
+        insert_ns += now_ns() - start;
+
+        if (rep == reps - 1) {
+            info.capacity = ht->size;
+            info.load = (double)ht->count / ht->size;
+            bench_search(w, &info, ht, keys, n, 1, lookups, order, latencies);
+            bench_search(w, &info, ht, misses, n, 0, lookups, order, latencies);
+        }
+
+        start = now_ns();
+        for (int i = 0; i < n; i++) {
+            ht_delete(ht, keys->keys[i]);
+        }
+        delete_ns += now_ns() - start;
+        ht_del_hash_table(ht);
+    }
+
+    // Second build timing every operation, for the percentiles
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) return;
+    for (int i = 0; i < n; i++) {
+        const double start = now_ns();
+        ht_insert(ht, keys->keys[i], "value");
+        latencies[i] = now_ns() - start;
+    }
+    write_row(w, &info, "insert", (long)n * reps, insert_ns, latencies, n);
+
+    for (int i = 0; i < n; i++) {
+        const double start = now_ns();
+        ht_delete(ht, keys->keys[i]);
+        latencies[i] = now_ns() - start;
+    }
+    write_row(w, &info, "delete", (long)n * reps, delete_ns, latencies, n);
+    ht_del_hash_table(ht);
+}
+
+// Grows a table until it has at least n/2 buckets, then keeps inserting and
+// measures lookups each time the load passes a target. Targets the table
+// cannot reach without resizing (or without more than n keys) are skipped.
+static void bench_load(writer* w, key_kind kind, const key_set* keys, const key_set* misses,
+                       int n, int lookups, const int* order, double* latencies) {
+    row_info info = {key_kind_names[kind], "load", 0, 0, 0.0};
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) return;
+
+    int inserted = 0;
+    while (inserted < n && ht->size < n / 2) {
+        ht_insert(ht, keys->keys[inserted++], "value");
+    }
+
+    for (int t = 0; t < NUM_LOADS; t++) {
+        const int capacity = ht->size;
+        const int target = (int)(load_targets[t] * capacity);
+        while (inserted < n && ht->count < target && ht->size == capacity) {
+            ht_insert(ht, keys->keys[inserted++], "value");
+        }
+        if (ht->size != capacity || ht->count < target) {
+            break;
+        }
+
+        info.n = ht->count;
+        info.capacity = ht->size;
+        info.load = (double)ht->count / ht->size;
+        bench_search(w, &info, ht, keys, inserted, 1, lookups, order, latencies);
+        bench_search(w, &info, ht, misses, inserted, 0, lookups, order, latencies);
+    }
+    ht_del_hash_table(ht);
+}
+
+static int parse_list(char* arg, int* out, int max) {
+    int count = 0;
+    for (char* tok = strtok(arg, ","); tok != NULL && count < max; tok = strtok(NULL, ",")) {
+        out[count++] = atoi(tok);
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    int sizes[MAX_SIZES] = {1000, 10000, 100000, 1000000, 10000000};
+    int num_sizes = 5;
+    int use_kind[NUM_KEY_KINDS] = {1, 1, 1};
+    int lookups = 1000000;
+    writer w = {stdout, 0, 0};
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            num_sizes = parse_list(argv[++i], sizes, MAX_SIZES);
+        } else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            const char* list = argv[++i];
+            for (int k = 0; k < NUM_KEY_KINDS; k++) {
+                use_kind[k] = strstr(list, key_kind_names[k]) != NULL;
+            }
+        } else if (strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+            lookups = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            w.json = strcmp(argv[++i], "json") == 0;
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            w.out = fopen(argv[++i], "w");
+            if (w.out == NULL) {
+                fprintf(stderr, "Error: cannot open %s for writing\n", argv[i]);
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--sizes 1000,10000,...] [--keys short,url,mixed] "
+                            "[--lookups N] [--format csv|json] [--out PATH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int max_size = 0;
+    for (int s = 0; s < num_sizes; s++) {
+        if (sizes[s] <= 0) {
+            fprintf(stderr, "Error: sizes must be positive\n");
+            return 1;
+        }
+        if (sizes[s] > max_size) max_size = sizes[s];
+    }
+    if (lookups <= 0) {
+        fprintf(stderr, "Error: --lookups must be positive\n");
+        return 1;
+    }
+
+    const int num_latencies = max_size > lookups ? max_size : lookups;
+    double* latencies = malloc((size_t)num_latencies * sizeof(double));
+    int* order = malloc((size_t)lookups * sizeof(int));
+    if (latencies == NULL || order == NULL) {
+        fprintf(stderr, "Error: allocation failed\n");
+        return 1;
+    }
+    unsigned long long state = 88172645463325252ull;
+    for (int i = 0; i < lookups; i++) {
+        order[i] = (int)(next_rand(&state) & 0x7fffffff);
+    }
+
+    write_header(&w);
+    for (int k = 0; k < NUM_KEY_KINDS; k++) {
+        if (!use_kind[k]) continue;
+
+        // One key set per distribution, shared by every size (prefixes of it)
+        key_set keys, misses;
+        if (key_set_init(&keys, (key_kind)k, max_size, 0, 0x9e3779b97f4a7c15ull) != 0) return 1;
+        if (key_set_init(&misses, (key_kind)k, max_size, '~', 0xbf58476d1ce4e5b9ull) != 0) return 1;
+
+        for (int s = 0; s < num_sizes; s++) {
+            fprintf(stderr, "bench: %s %s n=%d\n", BENCH_LAYOUT, key_kind_names[k], sizes[s]);
+            bench_fill(&w, (key_kind)k, &keys, &misses, sizes[s], lookups, order, latencies);
+            bench_load(&w, (key_kind)k, &keys, &misses, sizes[s], lookups, order, latencies);
+        }
+
+        key_set_free(&keys);
+        key_set_free(&misses);
+    }
+    write_footer(&w);
+
+    if (w.out != stdout) fclose(w.out);
+    free(latencies);
+    free(order);
+    return 0;
+}
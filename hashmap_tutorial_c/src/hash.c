@@ -0,0 +1,99 @@
+#include <string.h>
+
+#include "hash.h"
+
+// Single-pass 64-bit hash in the style of wyhash: 16 bytes per step are
+// folded into the state with a 64x64->128 bit multiply, so cost is linear in
+// the key length and every input bit reaches every output bit.
+
+static const uint64_t HASH_SECRET[4] = {
+  0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+  0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+// Multiply `*a` by `*b`, leaving the low half in `*a` and the high half in `*b`
+static void hash_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = (__uint128_t)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  const uint64_t ha = *a >> 32, hb = *b >> 32;
+  const uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  const uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t hash_mix(uint64_t a, uint64_t b) {
+  hash_mum(&a, &b);
+  return a ^ b;
+}
+
+static uint64_t hash_read8(const uint8_t* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint64_t hash_read4(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// Reads 1-3 bytes without branching on the exact length
+static uint64_t hash_read3(const uint8_t* p, size_t k) {
+  return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed) {
+  const uint8_t* p = data;
+  uint64_t a, b;
+
+  seed ^= hash_mix(seed ^ HASH_SECRET[0], HASH_SECRET[1]);
+
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (hash_read4(p) << 32) | hash_read4(p + ((len >> 3) << 2));
+      b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = hash_read3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      // Three independent lanes so the multiplies can overlap
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = hash_mix(hash_read8(p) ^ HASH_SECRET[1], hash_read8(p + 8) ^ seed);
+        see1 = hash_mix(hash_read8(p + 16) ^ HASH_SECRET[2], hash_read8(p + 24) ^ see1);
+        see2 = hash_mix(hash_read8(p + 32) ^ HASH_SECRET[3], hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = hash_mix(hash_read8(p) ^ HASH_SECRET[1], hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    // Last 16 bytes, possibly overlapping the previous block
+    a = hash_read8(p + i - 16);
+    b = hash_read8(p + i - 8);
+  }
+
+  a ^= HASH_SECRET[1];
+  b ^= seed;
+  hash_mum(&a, &b);
+  return hash_mix(a ^ HASH_SECRET[0] ^ len, b ^ HASH_SECRET[1]);
+}
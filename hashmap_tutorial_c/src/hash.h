@@ -0,0 +1,8 @@
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Seed both table layouts hash keys with, so they agree on every hash
+#define HT_HASH_SEED 0x9e3779b97f4a7c15ull
+
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed);
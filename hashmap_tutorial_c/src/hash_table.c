@@ -3,38 +3,209 @@
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "hash_table.h"
+#include "hash.h"
 #include "prime.h"
 
 #define HT_INITIAL_BASE_SIZE 53
 #define HT_PRIME_1 163
 #define HT_PRIME_2 157
+#define HT_MIGRATE_STEP 16
+#define HT_PREFAULT_PAGES 2
+#define HT_PAGE_SIZE 4096
+#define HT_BATCH_WINDOW 16
 
-static ht_item HT_DELETED_ITEM = {NULL, NULL};
+#if defined(__GNUC__)
+#define HT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define HT_PREFETCH(p) ((void)0)
+#endif
 
-static ht_item* ht_new_item(const char* k, const char* v) {
-  ht_item* i = malloc(sizeof(ht_item));
-  if (i == NULL) {
-    return NULL;
+static ht_item HT_DELETED_ITEM = {NULL, NULL, 0, 0, 0, 0};
+
+#define HT_ARENA_CHUNK_SIZE (64 * 1024)
+#define HT_ARENA_COMPACT_MIN (64 * 1024)
+
+struct ht_arena_chunk {
+  struct ht_arena_chunk* next;
+  size_t used;
+  size_t cap;
+  uint64_t data[]; // uint64_t keeps every allocation 8-byte aligned
+};
+
+static void* ht_arena_alloc(ht_arena* arena, const size_t n) {
+  const size_t rounded = (n + 7) & ~(size_t)7;
+  struct ht_arena_chunk* chunk = arena->head;
+
+  if (chunk == NULL || chunk->cap - chunk->used < rounded) {
+    const size_t cap = rounded > HT_ARENA_CHUNK_SIZE ? rounded : HT_ARENA_CHUNK_SIZE;
+    chunk = malloc(sizeof(struct ht_arena_chunk) + cap);
+    if (chunk == NULL) {
+      return NULL;
+    }
+    chunk->next = arena->head;
+    chunk->used = 0;
+    chunk->cap = cap;
+    arena->head = chunk;
   }
-  
-  i->key = strdup(k);
-  if (i->key == NULL) {
-    free(i);
-    return NULL;
+
+  void* p = (char*)chunk->data + chunk->used;
+  chunk->used += rounded;
+  arena->live += n;
+  return p;
+}
+
+// Marks `n` bytes of an earlier allocation as garbage
+static void ht_arena_release(ht_arena* arena, const size_t n) {
+  arena->live -= n;
+  arena->dead += n;
+}
+
+static void ht_arena_free(ht_arena* arena) {
+  struct ht_arena_chunk* chunk = arena->head;
+  while (chunk != NULL) {
+    struct ht_arena_chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
   }
-  
-  i->value = strdup(v);
-  if (i->value == NULL) {
-    free(i->key);
-    free(i);
+  arena->head = NULL;
+  arena->live = 0;
+  arena->dead = 0;
+}
+
+// Bytes an item's record occupies: the item itself followed by key and,
+// unless borrowed, value. Both get a trailing NUL so string callers can use
+// them directly.
+static size_t ht_item_bytes(const size_t key_len, const size_t value_len, const int flags) {
+  const size_t value_bytes = (flags & HT_VALUE_BORROWED) ? 0 : value_len + 1;
+  return sizeof(ht_item) + key_len + 1 + value_bytes;
+}
+
+static ht_item* ht_new_item(ht_arena* arena, const void* k, const size_t key_len,
+                            const void* v, const size_t value_len, const int flags,
+                            const uint64_t hash) {
+  ht_item* i = ht_arena_alloc(arena, ht_item_bytes(key_len, value_len, flags));
+  if (i == NULL) {
     return NULL;
   }
-  
+  i->hash = hash;
+  i->key_len = key_len;
+  i->value_len = value_len;
+  i->flags = flags;
+  i->key = (char*)(i + 1);
+  memcpy(i->key, k, key_len);
+  i->key[key_len] = '\0';
+  if (flags & HT_VALUE_BORROWED) {
+    i->value = (char*)v;
+  } else {
+    i->value = i->key + key_len + 1;
+    memcpy(i->value, v, value_len);
+    i->value[value_len] = '\0';
+  }
   return i;
 }
 
+static void ht_del_item(ht_arena* arena, ht_item* i) {
+  ht_arena_release(arena, ht_item_bytes(i->key_len, i->value_len, i->flags));
+}
+
+// Copies the live items of `items` into `fresh`, collecting the copies in
+// `copies` so nothing is repointed until every copy has succeeded
+static int ht_copy_items(ht_arena* fresh, ht_item** items, const int size, ht_item** copies) {
+  for (int i = 0; i < size; i++) {
+    ht_item* item = items[i];
+    copies[i] = item;
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      copies[i] = ht_new_item(fresh, item->key, item->key_len, item->value,
+                              item->value_len, item->flags, item->hash);
+      if (copies[i] == NULL) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+// Copies every live item into a fresh arena, dropping dead bytes, and
+// repoints the bucket arrays at the copies
+static void ht_compact(ht_hash_table* ht) {
+  ht_arena fresh = {NULL, 0, 0};
+  ht_item** copies = malloc((size_t)ht->size * sizeof(ht_item*));
+  ht_item** old_copies = NULL;
+  if (ht->old_items != NULL) {
+    old_copies = malloc((size_t)ht->old_size * sizeof(ht_item*));
+  }
+
+  if (copies == NULL || (ht->old_items != NULL && old_copies == NULL) ||
+      !ht_copy_items(&fresh, ht->items, ht->size, copies) ||
+      (ht->old_items != NULL && !ht_copy_items(&fresh, ht->old_items, ht->old_size, old_copies))) {
+    // Leave the table on its old storage
+    ht_arena_free(&fresh);
+    free(copies);
+    free(old_copies);
+    return;
+  }
+
+  free(ht->items);
+  ht->items = copies;
+  if (ht->old_items != NULL) {
+    free(ht->old_items);
+    ht->old_items = old_copies;
+  }
+  ht_arena_free(&ht->arena);
+  ht->arena = fresh;
+}
+
+// Progressive tables compact a step at a time instead: the current chunks
+// become compact_from, new allocations go to an empty arena, and
+// ht_compact_step copies live items across as operations go by. `live`
+// carries over, since those items are still live, so the copies are not
+// counted twice. Compaction waits for any migration to finish, and resizes
+// wait for compaction, so compact_pos always indexes `items`.
+static void ht_maybe_compact(ht_hash_table* ht) {
+  if (ht->arena.dead <= HT_ARENA_COMPACT_MIN || ht->arena.dead <= ht->arena.live) {
+    return;
+  }
+  if (!ht->incremental) {
+    ht_compact(ht);
+  } else if (ht->compact_from.head == NULL && ht->old_items == NULL && ht->next_items == NULL) {
+    ht->compact_from = ht->arena;
+    ht->arena.head = NULL;
+    ht->arena.dead = 0;
+    ht->compact_pos = 0;
+  }
+}
+
+// Copies the items of up to `budget` slots out of compact_from, and frees
+// it once every slot has been visited. A failed copy is retried by the next
+// operation.
+static void ht_compact_step(ht_hash_table* ht, int budget) {
+  while (budget > 0 && ht->compact_pos < ht->size) {
+    ht_item* item = ht->items[ht->compact_pos];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ht_item* copy = ht_new_item(&ht->arena, item->key, item->key_len, item->value,
+                                  item->value_len, item->flags, item->hash);
+      if (copy == NULL) {
+        return;
+      }
+      ht->arena.live -= ht_item_bytes(item->key_len, item->value_len, item->flags);
+      ht->items[ht->compact_pos] = copy;
+    }
+    ht->compact_pos++;
+    budget--;
+  }
+
+  if (ht->compact_pos == ht->size) {
+    ht_arena_free(&ht->compact_from);
+    ht->compact_pos = 0;
+  }
+}
+
 static ht_hash_table *ht_new_sized(const int base_size) {
   ht_hash_table *ht = malloc(sizeof(ht_hash_table));
   if (ht == NULL)
@@ -43,8 +214,30 @@ static ht_hash_table *ht_new_sized(const int base_size) {
   }
 
   ht->base_size = base_size;
-  ht->size = next_prime(ht->base_size);
+  ht->size = prime_bucket_count(ht->base_size, &ht->size_magic);
   ht->count = 0;
+  ht->deleted = 0;
+  ht->ctrl = NULL;
+  ht->slots = NULL;
+  ht->arena.head = NULL;
+  ht->arena.live = 0;
+  ht->arena.dead = 0;
+  ht->incremental = 0;
+  ht->old_items = NULL;
+  ht->old_size = 0;
+  ht->old_magic = 0;
+  ht->migrate_pos = 0;
+  ht->next_items = NULL;
+  ht->next_base_size = 0;
+  ht->next_size = 0;
+  ht->next_magic = 0;
+  ht->prefault_pos = 0;
+  ht->compact_from.head = NULL;
+  ht->compact_from.live = 0;
+  ht->compact_from.dead = 0;
+  ht->compact_pos = 0;
+  ht->map = NULL;
+  ht->map_size = 0;
 
   ht->items = calloc((size_t)ht->size, sizeof(ht_item *));
   if (ht->items == NULL)
@@ -64,79 +257,279 @@ ht_hash_table* ht_new() {
   return ht;
 }
 
-static void ht_del_item(ht_item* i) {
-  free(i->key);
-  free(i->value);
-  free(i);
+// Like ht_new, but resizes and compacts progressively: instead of rehashing
+// or copying everything inside the insert/delete that crosses a threshold,
+// the new bucket array is faulted in and entries are moved or copied a few
+// slots per operation
+ht_hash_table* ht_new_incremental() {
+  ht_hash_table* ht = ht_new();
+  if (ht != NULL) {
+    ht->incremental = 1;
+  }
+  return ht;
 }
 
 void ht_del_hash_table(ht_hash_table* ht) {
-  for (int i = 0; i < ht->size; i++) {
-    ht_item* item = ht->items[i];
-    if (item != NULL && item != &HT_DELETED_ITEM) {
-      ht_del_item(item);
-    }
+  if (ht->map != NULL) {
+    munmap((void*)ht->map, ht->map_size);
   }
+  ht_arena_free(&ht->arena);
+  ht_arena_free(&ht->compact_from);
+  free(ht->next_items);
+  free(ht->old_items);
   free(ht->items);
   free(ht);
 }
 
-static long int_pow(int base, int exp) {
-  long result = 1;
+#ifdef HT_LEGACY_HASH
+// Original polynomial hash, kept for comparison (build with -DHT_LEGACY_HASH).
+// It is O(len^2) in the key length because of int_pow.
+#define HT_LEGACY_BUCKETS 2147483647
+
+// Unsigned throughout: powers of `a` overflow for long keys, and wrapping
+// is only defined for unsigned arithmetic
+static uint64_t int_pow(const uint64_t base, const int exp) {
+  uint64_t result = 1;
   for (int i = 0; i < exp; i++) {
     result *= base;
   }
   return result;
 }
 
-// Function hashes string `s` via prime `a` (larger than ASCII 128) into bucket < `m`
-static int ht_hash(const char *s, const int a, const int m) {
-  long hash = 0;
-  const int len_s = strlen(s);
+// Function hashes `len_s` bytes at `s` via prime `a` (larger than ASCII 128) into bucket < `m`
+static uint32_t ht_hash(const unsigned char *s, const int len_s, const uint64_t a, const uint64_t m) {
+  uint64_t hash = 0;
   for (int i = 0; i < len_s; i++) {
     hash += int_pow(a, len_s - (i + 1)) * s[i];
     hash = hash % m; // Prevent overflow by taking modulo inside loop
   }
-  return (int) hash;
+  return (uint32_t)hash;
 }
 
-static int ht_get_hash(const char *s, const int num_buckets, const int attempt) {
-  const int hash_a = ht_hash(s, HT_PRIME_1, num_buckets);
-  int hash_b = ht_hash(s, HT_PRIME_2, num_buckets);
-  if (hash_b % num_buckets == 0)
-    hash_b = 1;
-  return (hash_a + (attempt * hash_b)) % num_buckets;
+// Both polynomial hashes against a fixed modulus, packed so the result does
+// not depend on the table size and can be cached in the item
+static uint64_t ht_key_hash(const void *key, const size_t len) {
+  const uint64_t hash_a = (uint64_t)ht_hash(key, (int)len, HT_PRIME_1, HT_LEGACY_BUCKETS);
+  const uint64_t hash_b = (uint64_t)ht_hash(key, (int)len, HT_PRIME_2, HT_LEGACY_BUCKETS);
+  return (hash_a << 32) | hash_b;
 }
+#else
+// Full 64-bit hash of the key, computed once per operation and cached in ht_item
+static uint64_t ht_key_hash(const void *key, const size_t len) {
+  return hash_bytes(key, len, HT_HASH_SEED);
+}
+#endif
 
-static void ht_resize(ht_hash_table* ht, const int base_size) {
-  if (base_size < HT_INITIAL_BASE_SIZE) return;
+uint64_t ht_hash_key(const void* key, size_t key_len) {
+  return ht_key_hash(key, key_len);
+}
 
-  ht_hash_table* new_ht = ht_new_sized(base_size);
-  if (new_ht == NULL) {
-    fprintf(stderr, "Error: failed to resize hash table\n");
+// Double hashing: the upper half of `hash` picks the start bucket, the lower
+// half the step, so attempt k visits (start + k * step) % size. Walking that
+// by adding the step and wrapping once visits the same buckets (snapshots
+// depend on it), and `magic` = fastmod_magic(size) turns the two reductions
+// into multiplies; a probe never divides.
+typedef struct {
+  uint32_t idx;
+  uint32_t step;
+  uint32_t size;
+} ht_probe;
+
+static inline ht_probe ht_probe_start(const uint64_t hash, const int size, const uint64_t magic) {
+  ht_probe p;
+  p.size = (uint32_t)size;
+  p.idx = fastmod((uint32_t)(hash >> 32), magic, p.size);
+  p.step = fastmod((uint32_t)hash, magic, p.size);
+  if (p.step == 0)
+    p.step = 1;
+  return p;
+}
+
+static inline void ht_probe_next(ht_probe* p) {
+  p->idx += p->step; // both below size <= INT32_MAX, so no overflow
+  if (p->idx >= p->size)
+    p->idx -= p->size;
+}
+
+// Places an existing item into a bucket array known not to contain its key
+static void ht_place_item(ht_item** items, const int size, const uint64_t magic, ht_item* item) {
+  ht_probe p = ht_probe_start(item->hash, size, magic);
+  while (items[p.idx] != NULL) {
+    ht_probe_next(&p);
+  }
+  items[p.idx] = item;
+}
+
+static int ht_key_matches(const ht_item* item, const void* key, const size_t key_len, const uint64_t hash) {
+  return item->hash == hash && item->key_len == key_len && memcmp(item->key, key, key_len) == 0;
+}
+
+// Index of `key` in bucket array `items`, or -1
+static int ht_find(ht_item** items, const int size, const uint64_t magic, const void* key,
+                   const size_t key_len, const uint64_t hash) {
+  ht_probe p = ht_probe_start(hash, size, magic);
+  ht_item* item = items[p.idx];
+  int attempts = 1;
+
+  while (item != NULL && attempts < size) {
+    if (item != &HT_DELETED_ITEM) {
+      if (ht_key_matches(item, key, key_len, hash)) {
+        return (int)p.idx;
+      }
+    }
+    ht_probe_next(&p);
+    item = items[p.idx];
+    attempts++;
+  }
+  return -1;
+}
+
+// Moves up to `budget` slots of the old bucket array into the current one.
+// Migrated slots become tombstones so probe chains through them stay intact.
+// Slots go across HT_MIGRATE_STEP at a time, with the items and then their
+// new buckets prefetched first, so one step pays about two cache misses
+// instead of two per item.
+static void ht_migrate(ht_hash_table* ht, int budget) {
+  while (budget > 0 && ht->migrate_pos < ht->old_size) {
+    int n = ht->old_size - ht->migrate_pos;
+    if (n > budget) n = budget;
+    if (n > HT_MIGRATE_STEP) n = HT_MIGRATE_STEP;
+    ht_item** src = ht->old_items + ht->migrate_pos;
+
+    for (int i = 0; i < n; i++) {
+      if (src[i] != NULL && src[i] != &HT_DELETED_ITEM) HT_PREFETCH(src[i]);
+    }
+    for (int i = 0; i < n; i++) {
+      if (src[i] != NULL && src[i] != &HT_DELETED_ITEM) {
+        HT_PREFETCH(&ht->items[ht_probe_start(src[i]->hash, ht->size, ht->size_magic).idx]);
+      }
+    }
+    for (int i = 0; i < n; i++) {
+      if (src[i] != NULL && src[i] != &HT_DELETED_ITEM) {
+        ht_place_item(ht->items, ht->size, ht->size_magic, src[i]);
+        src[i] = &HT_DELETED_ITEM;
+      }
+    }
+    ht->migrate_pos += n;
+    budget -= n;
+  }
+
+  if (ht->migrate_pos == ht->old_size) {
+    free(ht->old_items);
+    ht->old_items = NULL;
+    ht->old_size = 0;
+    ht->old_magic = 0;
+    ht->migrate_pos = 0;
+  }
+}
+
+// Writes a byte to up to `pages` pages of the pending bucket array. calloc
+// hands large arrays back as untouched zero pages, and without this their
+// faults land on the first few migration steps, a dozen per step, as items
+// scatter across the new array. Once every page is resident the array
+// replaces `items` and migration starts.
+static void ht_prefault(ht_hash_table* ht, int pages) {
+  const size_t bytes = (size_t)ht->next_size * sizeof(ht_item*);
+  volatile char* p = (volatile char*)ht->next_items;
+  while (pages > 0 && ht->prefault_pos < bytes) {
+    p[ht->prefault_pos] = 0;
+    ht->prefault_pos += HT_PAGE_SIZE;
+    pages--;
+  }
+  if (ht->prefault_pos < bytes) {
     return;
   }
 
-  for (int i = 0; i < ht->size; i++) {
-    ht_item* item = ht->items[i];
-    if (item != NULL && item != &HT_DELETED_ITEM) {
-      ht_insert(new_ht, item->key, item->value);
+  ht->old_items = ht->items;
+  ht->old_size = ht->size;
+  ht->old_magic = ht->size_magic;
+  ht->migrate_pos = 0;
+  ht->items = ht->next_items;
+  ht->size = ht->next_size;
+  ht->size_magic = ht->next_magic;
+  ht->base_size = ht->next_base_size;
+  ht->deleted = 0;
+  ht->next_items = NULL;
+  ht->next_base_size = 0;
+  ht->next_size = 0;
+  ht->next_magic = 0;
+  ht->prefault_pos = 0;
+}
+
+// Moves every live item on `hash`'s probe path through the old bucket array
+// into the current one, the key itself included if it is still there. An
+// insert has to walk that path anyway to rule the key out, and the items it
+// passes are already in cache, so moving them is migration work done at a
+// discount. Returns the number of items moved.
+static int ht_migrate_path(ht_hash_table* ht, const uint64_t hash) {
+  ht_probe p = ht_probe_start(hash, ht->old_size, ht->old_magic);
+  int moved = 0;
+
+  for (int attempts = 1; attempts < ht->old_size; attempts++) {
+    ht_item* item = ht->old_items[p.idx];
+    if (item == NULL) break;
+    if (item != &HT_DELETED_ITEM) {
+      ht_place_item(ht->items, ht->size, ht->size_magic, item);
+      ht->old_items[p.idx] = &HT_DELETED_ITEM;
+      moved++;
     }
+    ht_probe_next(&p);
   }
+  return moved;
+}
 
-  ht->base_size = new_ht->base_size;
-  ht->count = new_ht->count;
+// A resize is pending or in progress in the background, so load thresholds
+// are not acted on. Each lasts a bounded number of operations, which bounds
+// how far past them the load can drift.
+static int ht_resize_busy(const ht_hash_table* ht) {
+  return ht->next_items != NULL || ht->compact_from.head != NULL;
+}
 
-  // To delete new_ht give it ht's size and items
-  const int tmp_size = ht->size;
-  ht->size = new_ht->size;
-  new_ht->size = tmp_size;
+static void ht_resize(ht_hash_table* ht, const int base_size) {
+  if (base_size < HT_INITIAL_BASE_SIZE) return;
 
-  ht_item** tmp_items = ht->items;
-  ht->items = new_ht->items;
-  new_ht->items = tmp_items;
+  // A previous progressive resize must finish before the next one starts
+  if (ht->next_items != NULL) {
+    ht_prefault(ht, INT32_MAX);
+  }
+  if (ht->old_items != NULL) {
+    ht_migrate(ht, ht->old_size);
+  }
 
-  ht_del_hash_table(new_ht);
+  uint64_t new_magic;
+  const int new_size = prime_bucket_count(base_size, &new_magic);
+  ht_item** new_items = calloc((size_t)new_size, sizeof(ht_item *));
+  if (new_items == NULL) {
+    fprintf(stderr, "Error: failed to resize hash table\n");
+    return;
+  }
+
+  if (ht->incremental) {
+    ht->next_items = new_items;
+    ht->next_base_size = base_size;
+    ht->next_size = new_size;
+    ht->next_magic = new_magic;
+    ht->prefault_pos = 0;
+    return;
+  }
+
+  ht_item** old_items = ht->items;
+  const int old_size = ht->size;
+  ht->items = new_items;
+  ht->size = new_size;
+  ht->size_magic = new_magic;
+  ht->base_size = base_size;
+  ht->deleted = 0;
+
+  // Move the existing items across; their cached hashes mean no rehashing,
+  // and their storage stays in ht's arena
+  for (int i = 0; i < old_size; i++) {
+    ht_item* item = old_items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ht_place_item(ht->items, ht->size, ht->size_magic, item);
+    }
+  }
+  free(old_items);
 }
 
 static void ht_resize_up(ht_hash_table* ht) {
@@ -149,86 +542,525 @@ static void ht_resize_down(ht_hash_table *ht) {
   ht_resize(ht, new_size);
 }
 
-void ht_insert(ht_hash_table* ht, const char* key, const char* value) {
-  const int load = ht->count * 100 / ht->size;
-  if (load > 70) ht_resize_up(ht);
+// Replaces an item's value, reusing its arena bytes when the new value fits
+static void ht_update_value(ht_hash_table* ht, ht_item* item, const void* value,
+                            const size_t value_len, const int flags) {
+  const int owned = !(item->flags & HT_VALUE_BORROWED);
+
+  if (flags & HT_VALUE_BORROWED) {
+    if (owned) ht_arena_release(&ht->arena, item->value_len + 1);
+    item->value = (char*)value;
+  } else if (owned && value_len <= item->value_len) {
+    memmove(item->value, value, value_len);
+    item->value[value_len] = '\0';
+    ht_arena_release(&ht->arena, item->value_len - value_len);
+  } else {
+    char* new_value = ht_arena_alloc(&ht->arena, value_len + 1);
+    if (new_value == NULL) {
+      fprintf(stderr, "Error: memory allocation failed\n");
+      return;
+    }
+    memcpy(new_value, value, value_len);
+    new_value[value_len] = '\0';
+    if (owned) ht_arena_release(&ht->arena, item->value_len + 1);
+    item->value = new_value;
+  }
+
+  item->value_len = value_len;
+  item->flags = flags;
+  ht_maybe_compact(ht);
+}
+
+void ht_insert_hashed(ht_hash_table* ht, const void* key, const size_t key_len,
+                      const void* value, const size_t value_len, const int flags,
+                      const uint64_t hash) {
+  if (ht->map != NULL) {
+    fprintf(stderr, "Error: hash table is read-only\n");
+    return;
+  }
+  if (ht->next_items != NULL) ht_prefault(ht, HT_PREFAULT_PAGES);
+  if (ht->compact_from.head != NULL) ht_compact_step(ht, HT_MIGRATE_STEP);
 
-  int idx = ht_get_hash(key, ht->size, 0);
-  ht_item* cur_item = ht->items[idx];
+  // Tombstones lengthen probe chains just like live items, so they count
+  // towards the 70% threshold. If they are most of the problem, rebuilding
+  // at the same size clears them without growing the table.
+  const int load = (ht->count + ht->deleted) * 100 / ht->size;
+  if (load > 70 && !ht_resize_busy(ht)) {
+    if (ht->count * 100 / ht->size > 35) ht_resize_up(ht);
+    else ht_resize(ht, ht->base_size);
+  }
+
+  // A key still waiting in the old bucket array is moved over first so the
+  // update below finds it; items moved along the way count against this
+  // operation's migration step
+  if (ht->old_items != NULL) {
+    const int moved = ht_migrate_path(ht, hash);
+    if (moved < HT_MIGRATE_STEP) ht_migrate(ht, HT_MIGRATE_STEP - moved);
+  }
+
+  ht_probe p = ht_probe_start(hash, ht->size, ht->size_magic);
+  ht_item* cur_item = ht->items[p.idx];
   int attempts = 1;
+  int tombstone = -1;
   
   while (cur_item != NULL && attempts < ht->size) {
-    if (cur_item != &HT_DELETED_ITEM) {
-      if (strcmp(cur_item->key, key) == 0) {
-        // Update existing key - just replace the value
-        char* new_value = strdup(value);
-        if (new_value == NULL) {
-          fprintf(stderr, "Error: memory allocation failed\n");
-          return;
-        }
-        free(cur_item->value);
-        cur_item->value = new_value;
+    if (cur_item == &HT_DELETED_ITEM) {
+      // Remember the first reusable slot, but keep looking for the key
+      if (tombstone < 0) tombstone = (int)p.idx;
+    } else {
+      if (ht_key_matches(cur_item, key, key_len, hash)) {
+        // Update existing key
+        ht_update_value(ht, cur_item, value, value_len, flags);
         return;
       }
     }
-    idx = ht_get_hash(key, ht->size, attempts);
-    cur_item = ht->items[idx];
+    ht_probe_next(&p);
+    cur_item = ht->items[p.idx];
     attempts++;
   }
   
-  if (attempts >= ht->size) {
+  int idx = (int)p.idx;
+  if (tombstone >= 0) {
+    idx = tombstone;
+  } else if (cur_item != NULL) {
     fprintf(stderr, "Error: hash table is full\n");
     return;
   }
   
   // Insert new item
-  ht_item* item = ht_new_item(key, value);
+  ht_item* item = ht_new_item(&ht->arena, key, key_len, value, value_len, flags, hash);
   if (item == NULL) {
     fprintf(stderr, "Error: failed to create hash table item\n");
     return;
   }
   
+  if (tombstone >= 0) ht->deleted--;
   ht->items[idx] = item;
   ht->count++;
 }
 
+void ht_insert_n(ht_hash_table* ht, const void* key, size_t key_len,
+                 const void* value, size_t value_len, int flags) {
+  ht_insert_hashed(ht, key, key_len, value, value_len, flags, ht_key_hash(key, key_len));
+}
+
+void ht_insert(ht_hash_table* ht, const char* key, const char* value) {
+  ht_insert_n(ht, key, strlen(key), value, strlen(value), 0);
+}
+
+static char* ht_mapped_search(ht_hash_table* ht, const void* key, const size_t key_len,
+                              const uint64_t hash, size_t* value_len);
+
+void* ht_search_hashed(ht_hash_table* ht, const void* key, const size_t key_len,
+                       const uint64_t hash, size_t* value_len) {
+  if (ht->map != NULL) {
+    return ht_mapped_search(ht, key, key_len, hash, value_len);
+  }
+
+  ht_item* item = NULL;
+  int idx = ht_find(ht->items, ht->size, ht->size_magic, key, key_len, hash);
+  if (idx >= 0) {
+    item = ht->items[idx];
+  } else if (ht->old_items != NULL) {
+    idx = ht_find(ht->old_items, ht->old_size, ht->old_magic, key, key_len, hash);
+    if (idx >= 0) {
+      item = ht->old_items[idx];
+    }
+  }
+
+  if (item == NULL) {
+    return NULL;
+  }
+  if (value_len != NULL) *value_len = item->value_len;
+  return item->value;
+}
+
+void* ht_search_n(ht_hash_table* ht, const void* key, size_t key_len, size_t* value_len) {
+  return ht_search_hashed(ht, key, key_len, ht_key_hash(key, key_len), value_len);
+}
+
 char* ht_search(ht_hash_table* ht, const char* key) {
-  int idx = ht_get_hash(key, ht->size, 0);
-  ht_item* item = ht->items[idx];
-  int attempts = 1;
-  
-  while (item != NULL && attempts < ht->size) {
-    if (item != &HT_DELETED_ITEM) {
-      if (strcmp(item->key, key) == 0) {
-        return item->value;
-      }
+  return ht_search_n(ht, key, strlen(key), NULL);
+}
+
+// Hashes a window of keys up front and prefetches their first bucket, then
+// the items those buckets point at, so the cache misses of the whole window
+// overlap instead of being paid one lookup at a time
+static void ht_prefetch_window(ht_hash_table* ht, const char** keys, const int n,
+                               uint64_t* hashes, size_t* lens) {
+  int idx[HT_BATCH_WINDOW];
+  for (int i = 0; i < n; i++) {
+    lens[i] = strlen(keys[i]);
+    hashes[i] = ht_key_hash(keys[i], lens[i]);
+    idx[i] = (int)ht_probe_start(hashes[i], ht->size, ht->size_magic).idx;
+    if (ht->map == NULL) HT_PREFETCH(&ht->items[idx[i]]);
+  }
+  if (ht->map != NULL) {
+    return;
+  }
+  for (int i = 0; i < n; i++) {
+    ht_item* item = ht->items[idx[i]];
+    if (item != NULL) {
+      HT_PREFETCH(item);
     }
-    idx = ht_get_hash(key, ht->size, attempts);
-    item = ht->items[idx];
-    attempts++;
   }
-  return NULL;
 }
 
-void ht_delete(ht_hash_table *ht, const char *key) {
+void ht_search_batch(ht_hash_table* ht, const char** keys, const int n, char** out_values) {
+  uint64_t hashes[HT_BATCH_WINDOW];
+  size_t lens[HT_BATCH_WINDOW];
+  for (int start = 0; start < n; start += HT_BATCH_WINDOW) {
+    const int len = n - start < HT_BATCH_WINDOW ? n - start : HT_BATCH_WINDOW;
+    ht_prefetch_window(ht, keys + start, len, hashes, lens);
+    for (int i = 0; i < len; i++) {
+      out_values[start + i] = ht_search_hashed(ht, keys[start + i], lens[i], hashes[i], NULL);
+    }
+  }
+}
+
+void ht_insert_batch(ht_hash_table* ht, const char** keys, const char** values, const int n) {
+  if (ht->map != NULL) {
+    fprintf(stderr, "Error: hash table is read-only\n");
+    return;
+  }
+  uint64_t hashes[HT_BATCH_WINDOW];
+  size_t lens[HT_BATCH_WINDOW];
+  for (int start = 0; start < n; start += HT_BATCH_WINDOW) {
+    const int len = n - start < HT_BATCH_WINDOW ? n - start : HT_BATCH_WINDOW;
+    ht_prefetch_window(ht, keys + start, len, hashes, lens);
+    for (int i = 0; i < len; i++) {
+      ht_insert_hashed(ht, keys[start + i], lens[i], values[start + i],
+                       strlen(values[start + i]), 0, hashes[i]);
+    }
+  }
+}
+
+void ht_delete_n(ht_hash_table *ht, const void *key, size_t key_len) {
+  ht_delete_hashed(ht, key, key_len, ht_key_hash(key, key_len));
+}
+
+void ht_delete_hashed(ht_hash_table* ht, const void* key, const size_t key_len, const uint64_t hash) {
+  if (ht->map != NULL) {
+    fprintf(stderr, "Error: hash table is read-only\n");
+    return;
+  }
+  if (ht->next_items != NULL) ht_prefault(ht, HT_PREFAULT_PAGES);
+  if (ht->old_items != NULL) ht_migrate(ht, HT_MIGRATE_STEP);
+  if (ht->compact_from.head != NULL) ht_compact_step(ht, HT_MIGRATE_STEP);
+
   const int load = ht->count * 100 / ht->size;
-  if (load < 10) ht_resize_down(ht);
-  
-  int index = ht_get_hash(key, ht->size, 0);
-  ht_item *item = ht->items[index];
-  int i = 1;
+  if (load < 10 && !ht_resize_busy(ht)) ht_resize_down(ht);
   
-  while (item != NULL && i < ht->size) {
-    if (item != &HT_DELETED_ITEM) {
-      if (strcmp(item->key, key) == 0) {
-        ht_del_item(item);
-        ht->items[index] = &HT_DELETED_ITEM;
-        ht->count--;
-        return;
+  ht_item** items = ht->items;
+  int index = ht_find(ht->items, ht->size, ht->size_magic, key, key_len, hash);
+  if (index < 0 && ht->old_items != NULL) {
+    items = ht->old_items;
+    index = ht_find(ht->old_items, ht->old_size, ht->old_magic, key, key_len, hash);
+  }
+  if (index < 0) {
+    return;
+  }
+
+  ht_del_item(&ht->arena, items[index]);
+  items[index] = &HT_DELETED_ITEM;
+  // Tombstones left in a draining old array vanish with it
+  if (items == ht->items) ht->deleted++;
+  ht->count--;
+  ht_maybe_compact(ht);
+}
+
+void ht_delete(ht_hash_table *ht, const char *key) {
+  ht_delete_n(ht, key, strlen(key));
+}
+
+// Number of probes `hash` needs to reach bucket `idx` of `items`
+static int ht_probe_length(const uint64_t hash, const int size, const uint64_t magic, const int idx) {
+  ht_probe p = ht_probe_start(hash, size, magic);
+  int probes = 1;
+  while ((int)p.idx != idx) {
+    ht_probe_next(&p);
+    probes++;
+  }
+  return probes;
+}
+
+// Number of buckets ht_find reads before giving up on a key with `hash`
+// that `items` does not hold
+static int ht_miss_length(ht_item** items, const int size, const uint64_t magic, const uint64_t hash) {
+  ht_probe p = ht_probe_start(hash, size, magic);
+  int probes = 1;
+  while (items[p.idx] != NULL && probes < size) {
+    ht_probe_next(&p);
+    probes++;
+  }
+  return probes;
+}
+
+void ht_get_stats(ht_hash_table* ht, ht_stats* stats) {
+  long total_probes = 0;
+  stats->size = ht->size;
+  stats->count = ht->count;
+  stats->deleted = ht->deleted;
+  stats->max_probe = 0;
+
+  if (ht->map != NULL) {
+    stats->avg_probe = 0.0;
+    return;
+  }
+
+  for (int i = 0; i < ht->size; i++) {
+    ht_item* item = ht->items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      const int probes = ht_probe_length(item->hash, ht->size, ht->size_magic, i);
+      total_probes += probes;
+      if (probes > stats->max_probe) stats->max_probe = probes;
+    }
+  }
+  for (int i = 0; i < ht->old_size; i++) {
+    ht_item* item = ht->old_items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      // Found only after a full miss in the current array
+      const int probes = ht_miss_length(ht->items, ht->size, ht->size_magic, item->hash) +
+                         ht_probe_length(item->hash, ht->old_size, ht->old_magic, i);
+      total_probes += probes;
+      if (probes > stats->max_probe) stats->max_probe = probes;
+    }
+  }
+
+  stats->avg_probe = ht->count > 0 ? (double)total_probes / ht->count : 0.0;
+}
+
+// Snapshot file layout. Everything is fixed-width and addressed by offset
+// from the start of the file, so a mapping can be read in place wherever it
+// lands:
+//
+//   ht_snapshot_header
+//   uint64_t slots[size]   record offset per bucket, 0 if empty
+//   records                ht_snapshot_record, key bytes + NUL, value bytes
+//                          + NUL, padded to 8 bytes
+//
+// Buckets use the same double hashing as the in-memory table, so a lookup
+// probes the mapped slots exactly as ht_search probes ht->items.
+
+#define HT_SNAPSHOT_MAGIC "HTSNAP01"
+#define HT_SNAPSHOT_VERSION 1
+#ifdef HT_LEGACY_HASH
+// 1 was the signed legacy hash, which differed for long keys
+#define HT_SNAPSHOT_HASH_KIND 2
+#else
+#define HT_SNAPSHOT_HASH_KIND 0
+#endif
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t hash_kind; // snapshots only load in a build using the same hash
+  uint64_t size;
+  uint64_t count;
+  uint64_t file_size;
+} ht_snapshot_header;
+
+typedef struct {
+  uint64_t hash;
+  uint64_t key_len;
+  uint64_t value_len;
+} ht_snapshot_record;
+
+static uint64_t ht_snapshot_record_bytes(const ht_item* item) {
+  const uint64_t n = sizeof(ht_snapshot_record) + item->key_len + 1 + item->value_len + 1;
+  return (n + 7) & ~(uint64_t)7;
+}
+
+// Claims a bucket for `item` in the snapshot's slot array and gives it the
+// next record offset
+static void ht_snapshot_place(uint64_t* slots, const int size, const uint64_t magic, const ht_item* item,
+                              uint64_t* offset) {
+  ht_probe p = ht_probe_start(item->hash, size, magic);
+  while (slots[p.idx] != 0) {
+    ht_probe_next(&p);
+  }
+  slots[p.idx] = *offset;
+  *offset += ht_snapshot_record_bytes(item);
+}
+
+static int ht_snapshot_write_record(FILE* f, const ht_item* item) {
+  static const char padding[8] = {0};
+  const ht_snapshot_record rec = {item->hash, item->key_len, item->value_len};
+  const size_t used = sizeof(rec) + item->key_len + 1 + item->value_len;
+  const size_t tail = (size_t)ht_snapshot_record_bytes(item) - used; // value NUL + padding
+  return fwrite(&rec, sizeof(rec), 1, f) == 1 &&
+         fwrite(item->key, 1, item->key_len + 1, f) == item->key_len + 1 &&
+         fwrite(item->value, 1, item->value_len, f) == item->value_len &&
+         fwrite(padding, 1, tail, f) == tail;
+}
+
+int ht_save(ht_hash_table* ht, const char* path) {
+  if (ht->map != NULL) {
+    fprintf(stderr, "Error: cannot save a mapped hash table\n");
+    return -1;
+  }
+
+  const int size = ht->size;
+  uint64_t* slots = calloc((size_t)size, sizeof(uint64_t));
+  if (slots == NULL) {
+    fprintf(stderr, "Error: memory allocation failed\n");
+    return -1;
+  }
+
+  // Tombstones are not written, so every item is re-placed along its probe
+  // sequence rather than keeping its bucket (a dropped tombstone would cut
+  // the chain). Records go to disk in the order offsets are handed out.
+  uint64_t offset = sizeof(ht_snapshot_header) + (uint64_t)size * sizeof(uint64_t);
+  for (int i = 0; i < size; i++) {
+    ht_item* item = ht->items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ht_snapshot_place(slots, size, ht->size_magic, item, &offset);
+    }
+  }
+  for (int i = 0; i < ht->old_size; i++) {
+    ht_item* item = ht->old_items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ht_snapshot_place(slots, size, ht->size_magic, item, &offset);
+    }
+  }
+
+  // Written beside `path` and renamed over it only once complete, so a
+  // failed save leaves the previous snapshot intact, and processes that have
+  // it mapped keep their (now unlinked) file instead of seeing it truncated
+  char* tmp_path = malloc(strlen(path) + sizeof(".tmp"));
+  if (tmp_path == NULL) {
+    fprintf(stderr, "Error: memory allocation failed\n");
+    free(slots);
+    return -1;
+  }
+  sprintf(tmp_path, "%s.tmp", path);
+  FILE* f = fopen(tmp_path, "wb");
+  if (f == NULL) {
+    fprintf(stderr, "Error: cannot open %s for writing\n", tmp_path);
+    free(tmp_path);
+    free(slots);
+    return -1;
+  }
+
+  ht_snapshot_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, HT_SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = HT_SNAPSHOT_VERSION;
+  header.hash_kind = HT_SNAPSHOT_HASH_KIND;
+  header.size = (uint64_t)size;
+  header.count = (uint64_t)ht->count;
+  header.file_size = offset;
+
+  int ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+           fwrite(slots, sizeof(uint64_t), (size_t)size, f) == (size_t)size;
+
+  for (int i = 0; i < size && ok; i++) {
+    ht_item* item = ht->items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ok = ht_snapshot_write_record(f, item);
+    }
+  }
+  for (int i = 0; i < ht->old_size && ok; i++) {
+    ht_item* item = ht->old_items[i];
+    if (item != NULL && item != &HT_DELETED_ITEM) {
+      ok = ht_snapshot_write_record(f, item);
+    }
+  }
+
+  ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+  if (fclose(f) != 0) ok = 0;
+  ok = ok && rename(tmp_path, path) == 0;
+  free(slots);
+  if (!ok) {
+    fprintf(stderr, "Error: failed writing snapshot %s\n", path);
+    remove(tmp_path);
+    free(tmp_path);
+    return -1;
+  }
+  free(tmp_path);
+  return 0;
+}
+
+ht_hash_table* ht_open_mmap(const char* path) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Error: cannot open %s\n", path);
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ht_snapshot_header)) {
+    fprintf(stderr, "Error: %s is not a hash table snapshot\n", path);
+    close(fd);
+    return NULL;
+  }
+
+  void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: cannot map %s\n", path);
+    return NULL;
+  }
+
+  const ht_snapshot_header* header = map;
+  if (memcmp(header->magic, HT_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != HT_SNAPSHOT_VERSION ||
+      header->hash_kind != HT_SNAPSHOT_HASH_KIND ||
+      header->file_size != (uint64_t)st.st_size ||
+      header->size == 0 || header->size > (uint64_t)INT32_MAX ||
+      header->size > (header->file_size - sizeof(*header)) / sizeof(uint64_t) ||
+      header->count > header->size) {
+    fprintf(stderr, "Error: %s is not a compatible hash table snapshot\n", path);
+    munmap(map, (size_t)st.st_size);
+    return NULL;
+  }
+
+  ht_hash_table* ht = malloc(sizeof(ht_hash_table));
+  if (ht == NULL) {
+    munmap(map, (size_t)st.st_size);
+    return NULL;
+  }
+  memset(ht, 0, sizeof(*ht));
+  ht->size = (int)header->size;
+  ht->size_magic = fastmod_magic((uint32_t)ht->size);
+  ht->base_size = ht->size;
+  ht->count = (int)header->count;
+  ht->map = map;
+  ht->map_size = (size_t)st.st_size;
+  return ht;
+}
+
+static char* ht_mapped_search(ht_hash_table* ht, const void* key, const size_t key_len,
+                              const uint64_t hash, size_t* value_len) {
+  const uint64_t* slots = (const uint64_t*)(ht->map + sizeof(ht_snapshot_header));
+  ht_probe p = ht_probe_start(hash, ht->size, ht->size_magic);
+  const uint64_t records_start = sizeof(ht_snapshot_header) + (uint64_t)ht->size * sizeof(uint64_t);
+  int attempts = 1;
+
+  while (slots[p.idx] != 0 && attempts < ht->size) {
+    // Only the header was checked at open, so opening stays O(1) whatever
+    // the file size; each record is bounds-checked here as a lookup reaches
+    // it, and a bad one ends the lookup as a miss
+    const uint64_t off = slots[p.idx];
+    if ((off & 7) != 0 || off < records_start || off > ht->map_size - sizeof(ht_snapshot_record)) {
+      return NULL;
+    }
+    const ht_snapshot_record* rec = (const ht_snapshot_record*)(ht->map + off);
+    const uint64_t room = ht->map_size - off - sizeof(*rec);
+    if (rec->key_len > room || rec->value_len > room - rec->key_len ||
+        room - rec->key_len - rec->value_len < 2) {
+      return NULL;
+    }
+    const char* rec_key = (const char*)(rec + 1);
+    if (rec->hash == hash && rec->key_len == key_len && memcmp(rec_key, key, key_len) == 0) {
+      if (rec_key[rec->key_len + 1 + rec->value_len] != '\0') {
+        return NULL;
       }
+      if (value_len != NULL) *value_len = rec->value_len;
+      return (char*)rec_key + rec->key_len + 1;
     }
-    index = ht_get_hash(key, ht->size, i);
-    item = ht->items[index];
-    i++;
+    ht_probe_next(&p);
+    attempts++;
   }
+  return NULL;
 }
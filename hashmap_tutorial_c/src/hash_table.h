@@ -1,18 +1,115 @@
+#include <stddef.h>
+#include <stdint.h>
+
+// ht_insert_n flag: store the caller's value pointer instead of a copy
+#define HT_VALUE_BORROWED 1
 
 typedef struct {
   char* key;
   char* value;
+  uint64_t hash; // full hash of key, lets probes skip the key compare on mismatch
+  size_t key_len;
+  size_t value_len;
+  int flags;     // HT_VALUE_BORROWED if value points at caller memory
 } ht_item;
 
+struct ht_flat_slot;
+struct ht_arena_chunk;
+
+// Bump allocator owned by the table. Items, keys and values are carved out of
+// large chunks; bytes of deleted or replaced entries are only counted as dead
+// and reclaimed by compaction.
+typedef struct {
+  struct ht_arena_chunk* head;
+  size_t live;
+  size_t dead;
+} ht_arena;
+
 typedef struct {
   int base_size;
   int size;
+  uint64_t size_magic; // fastmod_magic(size), see prime.h
   int count;
   ht_item** items;
+  ht_arena arena;
+  int deleted; // tombstones in the current bucket array
+  // Progressive resize (ht_new_incremental): a new bucket array is first
+  // faulted in a few pages per insert/delete (next_items), then becomes
+  // `items` while entries are moved out of old_items a bounded number of
+  // slots per operation, and lookups consult both arrays
+  int incremental;
+  ht_item** old_items;
+  int old_size;
+  uint64_t old_magic;
+  int migrate_pos;
+  ht_item** next_items;
+  int next_base_size;
+  int next_size;
+  uint64_t next_magic;
+  size_t prefault_pos;
+  // Progressive compaction: live items are copied out of compact_from into
+  // `arena` a bounded number of slots per operation
+  ht_arena compact_from;
+  int compact_pos;
+  // Read-only snapshot mapping (ht_open_mmap); NULL for ordinary tables
+  const unsigned char* map;
+  size_t map_size;
+  // Flat (Swiss table) layout, used instead of `items` when linked against
+  // hash_table_flat.c
+  signed char* ctrl;
+  struct ht_flat_slot* slots;
 } ht_hash_table;
 
+typedef struct {
+  int size;
+  int count;
+  int deleted;      // tombstones
+  double avg_probe; // mean buckets probed to find a live key
+  int max_probe;
+} ht_stats;
+
 ht_hash_table* ht_new();
+ht_hash_table* ht_new_incremental();
 void ht_del_hash_table(ht_hash_table *ht);
 void ht_insert(ht_hash_table *ht, const char *key, const char *value);
+// The returned value is owned by the table and stays valid until the next
+// ht_insert or ht_delete (either may compact the table's storage)
 char* ht_search(ht_hash_table* ht, const char* key);
 void ht_delete(ht_hash_table* ht, const char* key);
+
+// Length-aware forms for binary keys and values. Keys are compared with
+// memcmp. Values are copied (with a trailing NUL for convenience) unless
+// `flags` has HT_VALUE_BORROWED, in which case the table keeps the caller's
+// pointer and the caller keeps the bytes alive until the key is replaced or
+// deleted. ht_search_n stores the value length in `*value_len` if non-NULL.
+void ht_insert_n(ht_hash_table* ht, const void* key, size_t key_len,
+                 const void* value, size_t value_len, int flags);
+void* ht_search_n(ht_hash_table* ht, const void* key, size_t key_len, size_t* value_len);
+void ht_delete_n(ht_hash_table* ht, const void* key, size_t key_len);
+
+// Batched forms of ht_search/ht_insert. Keys are hashed and their buckets
+// prefetched a window at a time, so a run of lookups into a table larger
+// than cache overlaps its misses. out_values[i] receives ht_search(keys[i]).
+void ht_search_batch(ht_hash_table* ht, const char** keys, int n, char** out_values);
+void ht_insert_batch(ht_hash_table* ht, const char** keys, const char** values, int n);
+
+// Hash-once forms for callers that need the key's hash themselves (the
+// concurrent table picks a segment with it). `hash` must be
+// ht_hash_key(key, key_len). Provided by hash_table.c only.
+uint64_t ht_hash_key(const void* key, size_t key_len);
+void ht_insert_hashed(ht_hash_table* ht, const void* key, size_t key_len,
+                      const void* value, size_t value_len, int flags, uint64_t hash);
+void* ht_search_hashed(ht_hash_table* ht, const void* key, size_t key_len, uint64_t hash,
+                       size_t* value_len);
+void ht_delete_hashed(ht_hash_table* ht, const void* key, size_t key_len, uint64_t hash);
+
+// Walks the table to measure probe lengths; O(count), meant for diagnostics
+void ht_get_stats(ht_hash_table* ht, ht_stats* stats);
+
+// Writes a position-independent snapshot of `ht` to `path`; 0 on success.
+// ht_open_mmap maps such a file and serves ht_search/ht_search_n/
+// ht_search_batch straight from the mapping without loading it. The mapped
+// table is read-only and is released with ht_del_hash_table. Snapshots are
+// provided by hash_table.c only.
+int ht_save(ht_hash_table* ht, const char* path);
+ht_hash_table* ht_open_mmap(const char* path);
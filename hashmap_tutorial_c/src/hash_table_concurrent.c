@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "hash_table_concurrent.h"
+#include "hash_table.h"
+
+// Each segment is an ordinary ht_hash_table behind a reader-writer lock.
+// Searches take the lock shared; inserts and deletes take it exclusive, so a
+// segment resizing (or compacting its arena) never has readers inside it.
+// Segments use progressive resize, which bounds how long a writer holds the
+// lock. Values are copied out under the lock because the table may move them
+// as soon as it is released.
+//
+// Taking the lock shared still writes its reader count, so readers of one
+// segment do contend on its cache line; spreading keys over 64 segments is
+// what keeps them apart. Lock-free reads would need every bucket array and
+// arena chunk a reader might hold to outlive it (epoch-based reclamation in
+// the table itself), which the plain ht_hash_table underneath cannot offer.
+
+#define HT_CONCURRENT_SEGMENTS 64
+#define HT_CACHE_LINE 64
+
+// Each segment starts its own cache line, so readers locking neighbouring
+// segments do not bounce a shared line between cores
+typedef struct {
+  pthread_rwlock_t lock;
+  ht_hash_table* table;
+} __attribute__((aligned(HT_CACHE_LINE))) ht_segment;
+
+struct ht_concurrent_table {
+  ht_segment segments[HT_CONCURRENT_SEGMENTS];
+};
+
+// The key is hashed once; the segment comes from the same hash the table
+// probes with, remixed by a multiply so it does not just repeat the top bits
+// that pick the start bucket
+static ht_segment* ht_segment_for(ht_concurrent_table* ht, const uint64_t hash) {
+  return &ht->segments[(hash * 0x9e3779b97f4a7c15ull) >> 58];
+}
+
+ht_concurrent_table* ht_concurrent_new() {
+  ht_concurrent_table* ht = NULL;
+  if (posix_memalign((void**)&ht, HT_CACHE_LINE, sizeof(ht_concurrent_table)) != 0) {
+    ht = NULL;
+  }
+  if (ht == NULL) {
+    fprintf(stderr, "Error: failed to create hash table\n");
+    return NULL;
+  }
+
+  for (int i = 0; i < HT_CONCURRENT_SEGMENTS; i++) {
+    ht_segment* seg = &ht->segments[i];
+    seg->table = ht_new_incremental();
+    if (seg->table == NULL || pthread_rwlock_init(&seg->lock, NULL) != 0) {
+      if (seg->table != NULL) ht_del_hash_table(seg->table);
+      for (int j = 0; j < i; j++) {
+        pthread_rwlock_destroy(&ht->segments[j].lock);
+        ht_del_hash_table(ht->segments[j].table);
+      }
+      free(ht);
+      fprintf(stderr, "Error: failed to create hash table\n");
+      return NULL;
+    }
+  }
+  return ht;
+}
+
+void ht_concurrent_del_hash_table(ht_concurrent_table* ht) {
+  for (int i = 0; i < HT_CONCURRENT_SEGMENTS; i++) {
+    pthread_rwlock_destroy(&ht->segments[i].lock);
+    ht_del_hash_table(ht->segments[i].table);
+  }
+  free(ht);
+}
+
+void ht_concurrent_insert(ht_concurrent_table* ht, const char* key, const char* value) {
+  const size_t key_len = strlen(key);
+  const uint64_t hash = ht_hash_key(key, key_len);
+  ht_segment* seg = ht_segment_for(ht, hash);
+  pthread_rwlock_wrlock(&seg->lock);
+  ht_insert_hashed(seg->table, key, key_len, value, strlen(value), 0, hash);
+  pthread_rwlock_unlock(&seg->lock);
+}
+
+int ht_concurrent_search(ht_concurrent_table* ht, const char* key, char* out, size_t out_size,
+                         size_t* value_len) {
+  const size_t key_len = strlen(key);
+  const uint64_t hash = ht_hash_key(key, key_len);
+  ht_segment* seg = ht_segment_for(ht, hash);
+  size_t len = 0;
+  int found = 0;
+  pthread_rwlock_rdlock(&seg->lock);
+  const char* value = ht_search_hashed(seg->table, key, key_len, hash, &len);
+  if (value != NULL) {
+    found = len < out_size ? 1 : -1;
+    if (found == 1) memcpy(out, value, len + 1);
+  }
+  pthread_rwlock_unlock(&seg->lock);
+  if (value != NULL && value_len != NULL) *value_len = len;
+  return found;
+}
+
+void ht_concurrent_delete(ht_concurrent_table* ht, const char* key) {
+  const size_t key_len = strlen(key);
+  const uint64_t hash = ht_hash_key(key, key_len);
+  ht_segment* seg = ht_segment_for(ht, hash);
+  pthread_rwlock_wrlock(&seg->lock);
+  ht_delete_hashed(seg->table, key, key_len, hash);
+  pthread_rwlock_unlock(&seg->lock);
+}
+
+// Sum of all segment counts; only exact while no writers are running
+int ht_concurrent_count(ht_concurrent_table* ht) {
+  int count = 0;
+  for (int i = 0; i < HT_CONCURRENT_SEGMENTS; i++) {
+    ht_segment* seg = &ht->segments[i];
+    pthread_rwlock_rdlock(&seg->lock);
+    count += seg->table->count;
+    pthread_rwlock_unlock(&seg->lock);
+  }
+  return count;
+}
@@ -0,0 +1,20 @@
+
+#include <stddef.h>
+
+// Thread-safe hash table. Keys are spread over independently locked segments
+// so threads touching different segments never contend, and readers of the
+// same segment share its lock.
+typedef struct ht_concurrent_table ht_concurrent_table;
+
+ht_concurrent_table* ht_concurrent_new();
+void ht_concurrent_del_hash_table(ht_concurrent_table* ht);
+void ht_concurrent_insert(ht_concurrent_table* ht, const char* key, const char* value);
+// Copies the value for `key`, NUL-terminated, into `out`. Returns 1 if the
+// key was found, 0 if not, and -1 if the value and its NUL do not fit in
+// `out_size` bytes, leaving `out` untouched. Whenever the key is found its
+// full value length goes to `*value_len` if non-NULL, so a caller can retry
+// with a large enough buffer.
+int ht_concurrent_search(ht_concurrent_table* ht, const char* key, char* out, size_t out_size,
+                         size_t* value_len);
+void ht_concurrent_delete(ht_concurrent_table* ht, const char* key);
+int ht_concurrent_count(ht_concurrent_table* ht);
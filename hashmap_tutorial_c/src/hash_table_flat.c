@@ -0,0 +1,373 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hash_table.h"
+#include "hash.h"
+
+// Flat open-addressing layout (Swiss table style). Drop-in replacement for
+// hash_table.c: link against this file instead to switch.
+//
+// Entries live inline in one `slots` array. A parallel `ctrl` array holds one
+// byte per slot: the low 7 bits of the hash for a full slot, or one of the
+// negative EMPTY/DELETED markers. Probing walks 16-slot groups and checks a
+// whole group's control bytes with one SSE2 compare, so the key is only
+// touched for slots whose 7-bit fragment already matches.
+
+#define HT_FLAT_GROUP 16
+#define HT_FLAT_INITIAL_SIZE 32
+#define HT_BATCH_WINDOW 16
+
+#if defined(__GNUC__)
+#define HT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define HT_PREFETCH(p) ((void)0)
+#endif
+
+#define HT_CTRL_EMPTY ((signed char)-128)
+#define HT_CTRL_DELETED ((signed char)-2)
+
+struct ht_flat_slot {
+  uint64_t hash;
+  char* key;   // single allocation holding "key\0value\0" ("key\0" if borrowed)
+  char* value; // points into the key allocation, or at caller memory if borrowed
+  size_t key_len;
+  size_t value_len;
+};
+
+// Bitmask of the slots in `group` whose control byte equals `c`
+static unsigned ht_flat_match(const signed char* group, const signed char c) {
+#if defined(__SSE2__)
+  const __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+  return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+  unsigned mask = 0;
+  for (int i = 0; i < HT_FLAT_GROUP; i++) {
+    if (group[i] == c) mask |= 1u << i;
+  }
+  return mask;
+#endif
+}
+
+// Bitmask of the slots in `group` that are empty or deleted (sign bit set)
+static unsigned ht_flat_match_free(const signed char* group) {
+#if defined(__SSE2__)
+  const __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+  return (unsigned)_mm_movemask_epi8(ctrl);
+#else
+  unsigned mask = 0;
+  for (int i = 0; i < HT_FLAT_GROUP; i++) {
+    if (group[i] < 0) mask |= 1u << i;
+  }
+  return mask;
+#endif
+}
+
+static int ht_flat_lowest_bit(const unsigned mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while (!(mask & (1u << i))) i++;
+  return i;
+#endif
+}
+
+static signed char ht_flat_h2(const uint64_t hash) {
+  return (signed char)(hash & 0x7f);
+}
+
+// Group-aligned triangular probing visits every group once when the number
+// of groups is a power of two
+static int ht_flat_group_at(const uint64_t hash, const int num_groups, const int attempt) {
+  const uint64_t start = hash >> 7;
+  return (int)((start + (uint64_t)attempt * (attempt + 1) / 2) & (uint64_t)(num_groups - 1));
+}
+
+static int ht_flat_alloc(ht_hash_table* ht, const int size) {
+  ht->ctrl = malloc((size_t)size);
+  if (ht->ctrl == NULL) {
+    return 0;
+  }
+  ht->slots = malloc((size_t)size * sizeof(struct ht_flat_slot));
+  if (ht->slots == NULL) {
+    free(ht->ctrl);
+    ht->ctrl = NULL;
+    return 0;
+  }
+  memset(ht->ctrl, HT_CTRL_EMPTY, (size_t)size);
+  ht->base_size = size;
+  ht->size = size;
+  ht->count = 0;
+  ht->deleted = 0;
+  return 1;
+}
+
+ht_hash_table* ht_new() {
+  // Zeroed so the pointer layout's fields (items, old_items, map, ...) read
+  // as unused by anything shared between the layouts
+  ht_hash_table* ht = calloc(1, sizeof(ht_hash_table));
+  if (ht == NULL) {
+    fprintf(stderr, "Error: failed to create hash table\n");
+    return NULL;
+  }
+  if (!ht_flat_alloc(ht, HT_FLAT_INITIAL_SIZE)) {
+    fprintf(stderr, "Error: failed to create hash table\n");
+    free(ht);
+    return NULL;
+  }
+  return ht;
+}
+
+// The flat layout always resizes in one step
+ht_hash_table* ht_new_incremental() {
+  return ht_new();
+}
+
+void ht_del_hash_table(ht_hash_table* ht) {
+  for (int i = 0; i < ht->size; i++) {
+    if (ht->ctrl[i] >= 0) {
+      free(ht->slots[i].key);
+    }
+  }
+  free(ht->ctrl);
+  free(ht->slots);
+  free(ht);
+}
+
+// Index of the first free slot along `hash`'s probe sequence
+static int ht_flat_find_free(const ht_hash_table* ht, const uint64_t hash) {
+  const int num_groups = ht->size / HT_FLAT_GROUP;
+  for (int attempt = 0; attempt < num_groups; attempt++) {
+    const int base = ht_flat_group_at(hash, num_groups, attempt) * HT_FLAT_GROUP;
+    const unsigned free_mask = ht_flat_match_free(ht->ctrl + base);
+    if (free_mask) {
+      return base + ht_flat_lowest_bit(free_mask);
+    }
+  }
+  return -1;
+}
+
+// Index of the slot holding `key`, or -1
+static int ht_flat_find(const ht_hash_table* ht, const void* key, const size_t key_len,
+                        const uint64_t hash) {
+  const int num_groups = ht->size / HT_FLAT_GROUP;
+  const signed char h2 = ht_flat_h2(hash);
+  for (int attempt = 0; attempt < num_groups; attempt++) {
+    const int base = ht_flat_group_at(hash, num_groups, attempt) * HT_FLAT_GROUP;
+    const signed char* group = ht->ctrl + base;
+    unsigned match = ht_flat_match(group, h2);
+    while (match) {
+      const int idx = base + ht_flat_lowest_bit(match);
+      const struct ht_flat_slot* slot = &ht->slots[idx];
+      if (slot->hash == hash && slot->key_len == key_len && memcmp(slot->key, key, key_len) == 0) {
+        return idx;
+      }
+      match &= match - 1;
+    }
+    // An empty slot in the group means the key was never pushed further
+    if (ht_flat_match(group, HT_CTRL_EMPTY)) {
+      return -1;
+    }
+  }
+  return -1;
+}
+
+// Rebuilds the table at `new_size` slots, dropping tombstones. Entries are
+// moved, not copied.
+static void ht_flat_resize(ht_hash_table* ht, const int new_size) {
+  signed char* old_ctrl = ht->ctrl;
+  struct ht_flat_slot* old_slots = ht->slots;
+  const int old_size = ht->size;
+  const int old_count = ht->count;
+
+  if (!ht_flat_alloc(ht, new_size)) {
+    fprintf(stderr, "Error: failed to resize hash table\n");
+    ht->ctrl = old_ctrl;
+    ht->slots = old_slots;
+    return;
+  }
+
+  for (int i = 0; i < old_size; i++) {
+    if (old_ctrl[i] >= 0) {
+      const int idx = ht_flat_find_free(ht, old_slots[i].hash);
+      ht->ctrl[idx] = old_ctrl[i];
+      ht->slots[idx] = old_slots[i];
+    }
+  }
+  ht->count = old_count;
+
+  free(old_ctrl);
+  free(old_slots);
+}
+
+static void ht_flat_insert_hashed(ht_hash_table* ht, const void* key, const size_t key_len,
+                                  const void* value, const size_t value_len, const int flags,
+                                  const uint64_t hash) {
+  const int borrowed = flags & HT_VALUE_BORROWED;
+  char* block = malloc(key_len + 1 + (borrowed ? 0 : value_len + 1));
+  if (block == NULL) {
+    fprintf(stderr, "Error: memory allocation failed\n");
+    return;
+  }
+  memcpy(block, key, key_len);
+  block[key_len] = '\0';
+  char* stored_value = (char*)value;
+  if (!borrowed) {
+    stored_value = block + key_len + 1;
+    memcpy(stored_value, value, value_len);
+    stored_value[value_len] = '\0';
+  }
+
+  const int existing = ht_flat_find(ht, key, key_len, hash);
+  if (existing >= 0) {
+    // Update existing key - swap in the new key/value block
+    free(ht->slots[existing].key);
+    ht->slots[existing].key = block;
+    ht->slots[existing].value = stored_value;
+    ht->slots[existing].value_len = value_len;
+    return;
+  }
+
+  // Keep the table at most 7/8 full counting tombstones. If tombstones are
+  // the problem, rebuild at the same size rather than growing.
+  if ((ht->count + ht->deleted + 1) * 8 > ht->size * 7) {
+    const int new_size = (ht->count + 1) * 2 > ht->size ? ht->size * 2 : ht->size;
+    ht_flat_resize(ht, new_size);
+  }
+
+  const int idx = ht_flat_find_free(ht, hash);
+  if (idx < 0) {
+    fprintf(stderr, "Error: hash table is full\n");
+    free(block);
+    return;
+  }
+
+  if (ht->ctrl[idx] == HT_CTRL_DELETED) ht->deleted--;
+  ht->ctrl[idx] = ht_flat_h2(hash);
+  ht->slots[idx].hash = hash;
+  ht->slots[idx].key = block;
+  ht->slots[idx].value = stored_value;
+  ht->slots[idx].key_len = key_len;
+  ht->slots[idx].value_len = value_len;
+  ht->count++;
+}
+
+void ht_insert_n(ht_hash_table* ht, const void* key, size_t key_len,
+                 const void* value, size_t value_len, int flags) {
+  ht_flat_insert_hashed(ht, key, key_len, value, value_len, flags,
+                        hash_bytes(key, key_len, HT_HASH_SEED));
+}
+
+void ht_insert(ht_hash_table* ht, const char* key, const char* value) {
+  ht_insert_n(ht, key, strlen(key), value, strlen(value), 0);
+}
+
+void* ht_search_n(ht_hash_table* ht, const void* key, size_t key_len, size_t* value_len) {
+  const int idx = ht_flat_find(ht, key, key_len, hash_bytes(key, key_len, HT_HASH_SEED));
+  if (idx < 0) {
+    return NULL;
+  }
+  if (value_len != NULL) *value_len = ht->slots[idx].value_len;
+  return ht->slots[idx].value;
+}
+
+char* ht_search(ht_hash_table* ht, const char* key) {
+  return ht_search_n(ht, key, strlen(key), NULL);
+}
+
+// Hashes a window of keys and prefetches the control bytes and slots of each
+// key's first group before any of them is probed
+static void ht_flat_prefetch_window(ht_hash_table* ht, const char** keys, const int n,
+                                    uint64_t* hashes, size_t* lens) {
+  const int num_groups = ht->size / HT_FLAT_GROUP;
+  for (int i = 0; i < n; i++) {
+    lens[i] = strlen(keys[i]);
+    hashes[i] = hash_bytes(keys[i], lens[i], HT_HASH_SEED);
+    const int base = ht_flat_group_at(hashes[i], num_groups, 0) * HT_FLAT_GROUP;
+    HT_PREFETCH(ht->ctrl + base);
+    HT_PREFETCH(ht->slots + base);
+  }
+}
+
+void ht_search_batch(ht_hash_table* ht, const char** keys, const int n, char** out_values) {
+  uint64_t hashes[HT_BATCH_WINDOW];
+  size_t lens[HT_BATCH_WINDOW];
+  for (int start = 0; start < n; start += HT_BATCH_WINDOW) {
+    const int len = n - start < HT_BATCH_WINDOW ? n - start : HT_BATCH_WINDOW;
+    ht_flat_prefetch_window(ht, keys + start, len, hashes, lens);
+    for (int i = 0; i < len; i++) {
+      const int idx = ht_flat_find(ht, keys[start + i], lens[i], hashes[i]);
+      out_values[start + i] = idx >= 0 ? ht->slots[idx].value : NULL;
+    }
+  }
+}
+
+void ht_insert_batch(ht_hash_table* ht, const char** keys, const char** values, const int n) {
+  uint64_t hashes[HT_BATCH_WINDOW];
+  size_t lens[HT_BATCH_WINDOW];
+  for (int start = 0; start < n; start += HT_BATCH_WINDOW) {
+    const int len = n - start < HT_BATCH_WINDOW ? n - start : HT_BATCH_WINDOW;
+    ht_flat_prefetch_window(ht, keys + start, len, hashes, lens);
+    for (int i = 0; i < len; i++) {
+      ht_flat_insert_hashed(ht, keys[start + i], lens[i], values[start + i],
+                            strlen(values[start + i]), 0, hashes[i]);
+    }
+  }
+}
+
+void ht_delete_n(ht_hash_table* ht, const void* key, size_t key_len) {
+  const int idx = ht_flat_find(ht, key, key_len, hash_bytes(key, key_len, HT_HASH_SEED));
+  if (idx < 0) {
+    return;
+  }
+
+  free(ht->slots[idx].key);
+  // If the group still has an empty slot no probe ever continued past it,
+  // so the slot can go straight back to empty instead of a tombstone
+  const signed char* group = ht->ctrl + (idx / HT_FLAT_GROUP) * HT_FLAT_GROUP;
+  if (ht_flat_match(group, HT_CTRL_EMPTY)) {
+    ht->ctrl[idx] = HT_CTRL_EMPTY;
+  } else {
+    ht->ctrl[idx] = HT_CTRL_DELETED;
+    ht->deleted++;
+  }
+  ht->count--;
+
+  const int load = ht->count * 100 / ht->size;
+  if (load < 10 && ht->size > HT_FLAT_INITIAL_SIZE) {
+    ht_flat_resize(ht, ht->size / 2);
+  }
+}
+
+void ht_delete(ht_hash_table* ht, const char* key) {
+  ht_delete_n(ht, key, strlen(key));
+}
+
+// Probe length is counted in groups: the number of 16-slot groups a lookup
+// inspects before reaching the entry's group
+void ht_get_stats(ht_hash_table* ht, ht_stats* stats) {
+  const int num_groups = ht->size / HT_FLAT_GROUP;
+  long total_probes = 0;
+  stats->size = ht->size;
+  stats->count = ht->count;
+  stats->deleted = ht->deleted;
+  stats->max_probe = 0;
+
+  for (int i = 0; i < ht->size; i++) {
+    if (ht->ctrl[i] >= 0) {
+      int attempts = 0;
+      while (ht_flat_group_at(ht->slots[i].hash, num_groups, attempts) != i / HT_FLAT_GROUP) {
+        attempts++;
+      }
+      total_probes += attempts + 1;
+      if (attempts + 1 > stats->max_probe) stats->max_probe = attempts + 1;
+    }
+  }
+
+  stats->avg_probe = ht->count > 0 ? (double)total_probes / ht->count : 0.0;
+}
@@ -3,6 +3,44 @@
 
 #include "prime.h"
 
+// next_prime(53 << k) for every k that fits an int, with its fastmod magic
+typedef struct {
+  int base_size;
+  int prime;
+  uint64_t magic;
+} prime_step;
+
+static const prime_step PRIME_LADDER[] = {
+  {53, 53, 0x04d4873ecade304eull},
+  {106, 107, 0x02647c69456217edull},
+  {212, 223, 0x0125e22708092f12ull},
+  {424, 431, 0x00980e4156201302ull},
+  {848, 853, 0x004cd47ba5f6ff1aull},
+  {1696, 1697, 0x00269e65ad07b18full},
+  {3392, 3407, 0x00133c564292d28bull},
+  {6784, 6791, 0x0009a681e758a023ull},
+  {13568, 13577, 0x0004d3b56870ae13ull},
+  {27136, 27143, 0x00026a1acded9220ull},
+  {54272, 54277, 0x0001351a85698862ull},
+  {108544, 108553, 0x00009a8da0033ebaull},
+  {217088, 217111, 0x00004d465b5fefd1ull},
+  {434176, 434179, 0x000026a42876df30ull},
+  {868352, 868369, 0x0000135204315665ull},
+  {1736704, 1736711, 0x000009a90bf053cbull},
+  {3473408, 3473419, 0x000004d4863e27c3ull},
+  {6946816, 6946817, 0x0000026a43999045ull},
+  {13893632, 13893637, 0x0000013521c86843ull},
+  {27787264, 27787267, 0x0000009a90e6c164ull},
+  {55574528, 55574567, 0x0000004d48705ec9ull},
+  {111149056, 111149057, 0x00000026a439f082ull},
+  {222298112, 222298127, 0x00000013521ce54dull},
+  {444596224, 444596227, 0x00000009a90e7c7eull},
+  {889192448, 889192471, 0x00000004d4873cb3ull},
+  {1778384896, 1778384921, 0x000000026a439ed4ull},
+};
+
+#define PRIME_LADDER_LEN (int)(sizeof(PRIME_LADDER) / sizeof(PRIME_LADDER[0]))
+
 int is_prime(const int x) {
   if (x < 2) return -1; // undefined
   if (x < 4) return 1; // prime
@@ -16,3 +54,19 @@ int next_prime(int x) {
   while (is_prime(x) != 1) x++;
   return x;
 }
+
+uint64_t fastmod_magic(const uint32_t d) {
+  return UINT64_MAX / d + 1;
+}
+
+int prime_bucket_count(const int base_size, uint64_t* magic) {
+  for (int i = 0; i < PRIME_LADDER_LEN; i++) {
+    if (PRIME_LADDER[i].base_size == base_size) {
+      *magic = PRIME_LADDER[i].magic;
+      return PRIME_LADDER[i].prime;
+    }
+  }
+  const int prime = next_prime(base_size);
+  *magic = fastmod_magic((uint32_t)prime);
+  return prime;
+}
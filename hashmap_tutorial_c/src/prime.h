@@ -1,3 +1,31 @@
+#ifndef PRIME_H
+#define PRIME_H
+
+#include <stdint.h>
 
 int is_prime(const int x);
 int next_prime(int x);
+
+// Lemire's fastmod: with m = fastmod_magic(d), fastmod(a, m, d) == a % d for
+// every 32-bit a and d > 0, in two multiplies instead of a divide
+uint64_t fastmod_magic(uint32_t d);
+
+static inline uint32_t fastmod(const uint32_t a, const uint64_t m, const uint32_t d) {
+  const uint64_t fraction = m * a;
+#if defined(__SIZEOF_INT128__)
+  return (uint32_t)(((unsigned __int128)fraction * d) >> 64);
+#else
+  // High half of the 64x32 product from two 32x32 partial products; the
+  // sum cannot overflow since d and both halves of fraction are below 2^32
+  const uint64_t lo = (fraction & 0xffffffffu) * d;
+  const uint64_t hi = (fraction >> 32) * d;
+  return (uint32_t)((hi + (lo >> 32)) >> 32);
+#endif
+}
+
+// next_prime(base_size), and its fastmod_magic in `*magic`. Base sizes on
+// the hash table's growth ladder (53 doubled or halved) are looked up in a
+// precomputed table; any other size is searched for.
+int prime_bucket_count(int base_size, uint64_t* magic);
+
+#endif
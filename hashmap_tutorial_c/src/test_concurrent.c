@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hash_table_concurrent.h"
+
+#define NUM_THREADS 8
+#define KEYS_PER_THREAD 5000
+
+typedef struct {int id; ht_concurrent_table* ht;} worker_arg_t;
+typedef struct {int errors;} worker_ret_t;
+
+// Helper function to print test results
+void print_test_header(const char* test_name) {
+    printf("\n========================================\n");
+    printf("TEST: %s\n", test_name);
+    printf("========================================\n");
+}
+
+void print_test_result(const char* description, int passed) {
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+}
+
+// Each worker owns its own key range: insert all, update all, delete the odd
+// ones, and verify its keys along the way. Other workers hit the same
+// segments concurrently and force resizes.
+void *stress_worker(void *arg) {
+    worker_arg_t *args = arg;
+    worker_ret_t *ret = malloc(sizeof(worker_ret_t));
+    char key[32], value[32], out[32];
+    ret->errors = 0;
+
+    for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        sprintf(key, "t%d_k%d", args->id, i);
+        sprintf(value, "v%d", i);
+        ht_concurrent_insert(args->ht, key, value);
+    }
+
+    for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        sprintf(key, "t%d_k%d", args->id, i);
+        sprintf(value, "v%d", i);
+        if (ht_concurrent_search(args->ht, key, out, sizeof(out), NULL) != 1 || strcmp(out, value) != 0) {
+            ret->errors++;
+        }
+        sprintf(value, "u%d", i);
+        ht_concurrent_insert(args->ht, key, value);
+    }
+
+    for (int i = 1; i < KEYS_PER_THREAD; i += 2) {
+        sprintf(key, "t%d_k%d", args->id, i);
+        ht_concurrent_delete(args->ht, key);
+    }
+
+    for (int i = 0; i < KEYS_PER_THREAD; i++) {
+        sprintf(key, "t%d_k%d", args->id, i);
+        sprintf(value, "u%d", i);
+        const int found = ht_concurrent_search(args->ht, key, out, sizeof(out), NULL) == 1;
+        if (i % 2 == 1 ? found : (!found || strcmp(out, value) != 0)) {
+            ret->errors++;
+        }
+    }
+    return ret;
+}
+
+// Readers scan a shared key set that is only ever updated to equal-length
+// values, so any torn read would show up as a mismatch
+void *reader_worker(void *arg) {
+    worker_arg_t *args = arg;
+    worker_ret_t *ret = malloc(sizeof(worker_ret_t));
+    char key[32], out[32];
+    ret->errors = 0;
+
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 1000; i++) {
+            sprintf(key, "shared_%d", i);
+            if (ht_concurrent_search(args->ht, key, out, sizeof(out), NULL) != 1 ||
+                (strcmp(out, "AAAA") != 0 && strcmp(out, "BBBB") != 0)) {
+                ret->errors++;
+            }
+        }
+    }
+    return ret;
+}
+
+void test_stress() {
+    print_test_header("Concurrent Insert/Search/Delete");
+
+    ht_concurrent_table* ht = ht_concurrent_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+
+    char key[32];
+    for (int i = 0; i < 1000; i++) {
+        sprintf(key, "shared_%d", i);
+        ht_concurrent_insert(ht, key, "AAAA");
+    }
+
+    pthread_t threads[NUM_THREADS * 2];
+    worker_arg_t args[NUM_THREADS * 2];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i] = (worker_arg_t){i, ht};
+        pthread_create(&threads[i], NULL, stress_worker, &args[i]);
+        args[NUM_THREADS + i] = (worker_arg_t){i, ht};
+        pthread_create(&threads[NUM_THREADS + i], NULL, reader_worker, &args[NUM_THREADS + i]);
+    }
+
+    // Flip the shared values while the readers run
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 1000; i++) {
+            sprintf(key, "shared_%d", i);
+            ht_concurrent_insert(ht, key, round % 2 ? "AAAA" : "BBBB");
+        }
+    }
+
+    int writer_errors = 0, reader_errors = 0;
+    for (int i = 0; i < NUM_THREADS * 2; i++) {
+        worker_ret_t *ret;
+        pthread_join(threads[i], (void **) &ret);
+        if (i < NUM_THREADS) writer_errors += ret->errors;
+        else reader_errors += ret->errors;
+        free(ret);
+    }
+
+    printf("\n%d writer threads, %d reader threads\n", NUM_THREADS, NUM_THREADS);
+    print_test_result("Writers saw their own inserts, updates and deletes", writer_errors == 0);
+    print_test_result("Readers never saw a missing or torn value", reader_errors == 0);
+    print_test_result("Final count matches",
+                      ht_concurrent_count(ht) == 1000 + NUM_THREADS * KEYS_PER_THREAD / 2);
+
+    ht_concurrent_del_hash_table(ht);
+}
+
+// Values that do not fit the caller's buffer are reported, not truncated
+void test_small_buffer() {
+    print_test_header("Search Into a Small Buffer");
+
+    ht_concurrent_table* ht = ht_concurrent_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    ht_concurrent_insert(ht, "key", "0123456789");
+
+    char out[16];
+    size_t len = 0;
+    strcpy(out, "untouched");
+    print_test_result("Too small a buffer is an error",
+                      ht_concurrent_search(ht, "key", out, 10, &len) == -1);
+    print_test_result("Buffer left untouched", strcmp(out, "untouched") == 0);
+    print_test_result("Full value length reported", len == 10);
+    print_test_result("Exact fit including the NUL",
+                      ht_concurrent_search(ht, "key", out, 11, NULL) == 1 && strcmp(out, "0123456789") == 0);
+    len = 0;
+    print_test_result("Missing key", ht_concurrent_search(ht, "nope", out, sizeof(out), &len) == 0 && len == 0);
+
+    ht_concurrent_del_hash_table(ht);
+}
+
+int main(void) {
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   CONCURRENT HASH TABLE TEST SUITE     ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+
+    test_stress();
+    test_small_buffer();
+
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   ALL TESTS COMPLETED                  ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("\n");
+
+    return 0;
+}
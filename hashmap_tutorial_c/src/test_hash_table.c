@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "hash_table.h"
+#include "prime.h"
 
 // Helper function to print test results
 void print_test_header(const char* test_name) {
@@ -256,6 +257,340 @@ void test_edge_cases() {
     ht_del_hash_table(ht);
 }
 
+// Test 7: Long URL-like keys sharing a common prefix
+void test_url_keys() {
+    print_test_header("URL Keys");
+    
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    
+    printf("\nInserting URL keys...\n");
+    char key[200], value[20];
+    int num_items = 500;
+    
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "https://example.com/api/v1/resources/collection/items/%d?include=details&format=json", i);
+        sprintf(value, "url_%d", i);
+        ht_insert(ht, key, value);
+    }
+    
+    print_hash_table_stats(ht);
+    
+    int all_found = 1;
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "https://example.com/api/v1/resources/collection/items/%d?include=details&format=json", i);
+        sprintf(value, "url_%d", i);
+        char* result = ht_search(ht, key);
+        if (result == NULL || strcmp(result, value) != 0) {
+            all_found = 0;
+            break;
+        }
+    }
+    print_test_result("All URL keys retrieved correctly", all_found);
+    print_test_result("Count matches insertions", ht->count == num_items);
+    
+    // Same prefix, different suffix must not match
+    char* missing = ht_search(ht, "https://example.com/api/v1/resources/collection/items/");
+    print_test_result("Prefix of stored key returns NULL", missing == NULL);
+    
+    ht_del_hash_table(ht);
+}
+
+// Test 8: Heavy update/delete churn (exercises storage compaction), once
+// with blocking compaction and once with progressive compaction
+void test_churn() {
+    print_test_header("Update and Delete Churn");
+    
+    for (int incremental = 0; incremental < 2; incremental++) {
+        ht_hash_table* ht = incremental ? ht_new_incremental() : ht_new();
+        if (ht == NULL) {
+            printf("Failed to create hash table\n");
+            return;
+        }
+        
+        char key[20], value[300];
+        int num_items = 1000;
+        int rounds_correct = 1;
+        
+        printf("\nInserting, growing and shrinking values (%s)...\n",
+               incremental ? "incremental" : "blocking");
+        for (int round = 0; round < 10; round++) {
+            // Alternate long and short values so updates both grow and shrink
+            int len = (round % 2 == 0) ? 200 + round : 5;
+            for (int i = 0; i < num_items; i++) {
+                sprintf(key, "churn_%d", i);
+                memset(value, 'a' + (i % 26), (size_t)len);
+                sprintf(value + len, "_%d", round);
+                ht_insert(ht, key, value);
+            }
+            // Compaction may still be partway through here
+            for (int i = 0; i < num_items; i++) {
+                sprintf(key, "churn_%d", i);
+                memset(value, 'a' + (i % 26), (size_t)len);
+                sprintf(value + len, "_%d", round);
+                char* result = ht_search(ht, key);
+                if (result == NULL || strcmp(result, value) != 0) rounds_correct = 0;
+            }
+        }
+        print_test_result("Every round reads back its values", rounds_correct);
+        
+        printf("Deleting every other key...\n");
+        for (int i = 0; i < num_items; i += 2) {
+            sprintf(key, "churn_%d", i);
+            ht_delete(ht, key);
+        }
+        
+        print_hash_table_stats(ht);
+        
+        int all_correct = 1;
+        for (int i = 0; i < num_items; i++) {
+            sprintf(key, "churn_%d", i);
+            char* result = ht_search(ht, key);
+            if (i % 2 == 0) {
+                if (result != NULL) all_correct = 0;
+            } else {
+                memset(value, 'a' + (i % 26), 5);
+                sprintf(value + 5, "_%d", 9);
+                if (result == NULL || strcmp(result, value) != 0) all_correct = 0;
+            }
+        }
+        print_test_result("Surviving keys hold their latest value", all_correct);
+        print_test_result("Count matches surviving keys", ht->count == num_items / 2);
+        
+        ht_del_hash_table(ht);
+    }
+}
+
+// Test 9: Progressive resize keeps every key reachable mid-migration
+void test_incremental_resize() {
+    print_test_header("Incremental Resize");
+    
+    ht_hash_table* ht = ht_new_incremental();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    
+    printf("\nInserting items while checking earlier ones...\n");
+    char key[20], value[30];
+    int num_items = 3000;
+    int all_found = 1;
+    
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "inc_%d", i);
+        sprintf(value, "value_%d", i);
+        ht_insert(ht, key, value);
+        
+        // Spot check a spread of earlier keys, which may sit in either array
+        for (int j = i; j >= 0; j -= 97) {
+            sprintf(key, "inc_%d", j);
+            sprintf(value, "value_%d", j);
+            char* result = ht_search(ht, key);
+            if (result == NULL || strcmp(result, value) != 0) all_found = 0;
+        }
+    }
+    print_hash_table_stats(ht);
+    print_test_result("All keys reachable during growth", all_found);
+    
+    printf("\nDeleting most items to trigger shrinking...\n");
+    for (int i = 0; i < num_items - 10; i++) {
+        sprintf(key, "inc_%d", i);
+        ht_delete(ht, key);
+    }
+    print_hash_table_stats(ht);
+    
+    int remaining_ok = 1;
+    for (int i = 0; i < num_items; i++) {
+        sprintf(key, "inc_%d", i);
+        sprintf(value, "value_%d", i);
+        char* result = ht_search(ht, key);
+        if (i < num_items - 10) {
+            if (result != NULL) remaining_ok = 0;
+        } else if (result == NULL || strcmp(result, value) != 0) {
+            remaining_ok = 0;
+        }
+    }
+    print_test_result("Only undeleted keys remain after shrinking", remaining_ok);
+    print_test_result("Count matches remaining keys", ht->count == 10);
+    
+    ht_del_hash_table(ht);
+}
+
+// Test 10: Batched insert and search
+void test_batch() {
+    print_test_header("Batch Insert and Search");
+    
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    
+    // Not a multiple of the batch window, and with one key repeated
+    enum { NUM_KEYS = 103 };
+    char key_buf[NUM_KEYS][20], value_buf[NUM_KEYS][20];
+    const char* keys[NUM_KEYS];
+    const char* values[NUM_KEYS];
+    char* results[NUM_KEYS + 1];
+    
+    for (int i = 0; i < NUM_KEYS; i++) {
+        sprintf(key_buf[i], "batch_%d", i);
+        sprintf(value_buf[i], "value_%d", i);
+        keys[i] = key_buf[i];
+        values[i] = value_buf[i];
+    }
+    keys[NUM_KEYS - 1] = key_buf[0];
+    
+    printf("\nInserting %d keys in one batch...\n", NUM_KEYS);
+    ht_insert_batch(ht, keys, values, NUM_KEYS);
+    print_hash_table_stats(ht);
+    print_test_result("Repeated key counted once", ht->count == NUM_KEYS - 1);
+    
+    const char* lookups[NUM_KEYS + 1];
+    for (int i = 0; i < NUM_KEYS; i++) {
+        lookups[i] = key_buf[i];
+    }
+    lookups[NUM_KEYS] = "batch_missing";
+    ht_search_batch(ht, lookups, NUM_KEYS + 1, results);
+    
+    int all_correct = 1;
+    for (int i = 1; i < NUM_KEYS - 1; i++) {
+        if (results[i] == NULL || strcmp(results[i], value_buf[i]) != 0) all_correct = 0;
+    }
+    print_test_result("Batch search matches inserted values", all_correct);
+    print_test_result("Later batch entry wins for repeated key",
+                      results[0] != NULL && strcmp(results[0], value_buf[NUM_KEYS - 1]) == 0);
+    print_test_result("Missing key in batch returns NULL", results[NUM_KEYS] == NULL);
+    
+    ht_del_hash_table(ht);
+}
+
+// Test 11: Constant insert/delete churn must not let tombstones pile up
+void test_tombstones() {
+    print_test_header("Tombstone Cleanup Under Churn");
+    
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    
+    // Session-cache shape: a sliding window of 500 live keys
+    char key[30];
+    int window = 500, total = 100000;
+    int initial_size = 0;
+    for (int i = 0; i < total; i++) {
+        sprintf(key, "session_%d", i);
+        ht_insert(ht, key, "data");
+        if (i >= window) {
+            sprintf(key, "session_%d", i - window);
+            ht_delete(ht, key);
+        }
+        if (i == window * 4) initial_size = ht->size;
+    }
+    
+    ht_stats stats;
+    ht_get_stats(ht, &stats);
+    print_hash_table_stats(ht);
+    printf("  Tombstones: %d\n", stats.deleted);
+    printf("  Avg probe: %.2f, max probe: %d\n", stats.avg_probe, stats.max_probe);
+    
+    int all_found = 1;
+    for (int i = total - window; i < total; i++) {
+        sprintf(key, "session_%d", i);
+        if (ht_search(ht, key) == NULL) all_found = 0;
+    }
+    print_test_result("Live window still reachable", all_found);
+    print_test_result("Count equals window", ht->count == window);
+    print_test_result("Table did not keep growing", ht->size <= initial_size);
+    print_test_result("Tombstones stay below table size", stats.deleted < ht->size / 2);
+    print_test_result("Average probe length stays short", stats.avg_probe < 4.0);
+    
+    ht_del_hash_table(ht);
+}
+
+// Test 12: Binary keys and values with embedded NUL bytes
+void test_binary_keys() {
+    print_test_header("Binary-Safe Keys and Values");
+    
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    
+    // Two keys that only differ after an embedded NUL
+    const unsigned char key_a[] = {0x01, 0x00, 0xff, 0x10};
+    const unsigned char key_b[] = {0x01, 0x00, 0xff, 0x11};
+    const unsigned char blob[] = {0xde, 0xad, 0x00, 0xbe, 0xef};
+    
+    printf("\nInserting binary keys...\n");
+    ht_insert_n(ht, key_a, sizeof(key_a), blob, sizeof(blob), 0);
+    ht_insert_n(ht, key_b, sizeof(key_b), "b", 1, 0);
+    print_test_result("Keys differing after NUL are distinct", ht->count == 2);
+    
+    size_t len = 0;
+    unsigned char* found = ht_search_n(ht, key_a, sizeof(key_a), &len);
+    print_test_result("Binary value round-trips with its length",
+                      found != NULL && len == sizeof(blob) && memcmp(found, blob, sizeof(blob)) == 0);
+    print_test_result("Key prefix does not match",
+                      ht_search_n(ht, key_a, 2, NULL) == NULL);
+    
+    printf("\nStoring a borrowed value...\n");
+    static const char shared[] = "shared-config-blob";
+    ht_insert_n(ht, key_b, sizeof(key_b), shared, sizeof(shared), HT_VALUE_BORROWED);
+    char* borrowed = ht_search_n(ht, key_b, sizeof(key_b), &len);
+    print_test_result("Borrowed value is the caller's pointer", borrowed == shared && len == sizeof(shared));
+    
+    ht_insert_n(ht, key_b, sizeof(key_b), "copied", 6, 0);
+    char* copied = ht_search_n(ht, key_b, sizeof(key_b), &len);
+    print_test_result("Replacing a borrowed value with a copy",
+                      copied != NULL && copied != shared && len == 6 && strcmp(copied, "copied") == 0);
+    
+    ht_delete_n(ht, key_a, sizeof(key_a));
+    print_test_result("Binary key deleted", ht_search_n(ht, key_a, sizeof(key_a), NULL) == NULL);
+    print_test_result("String API still sees string keys",
+                      (ht_insert(ht, "plain", "text"), ht_search(ht, "plain") != NULL));
+    
+    ht_del_hash_table(ht);
+}
+
+// Test 13: Bucket counts and the fastmod reduction probes use
+void test_prime_ladder() {
+    print_test_header("Prime Ladder and Fastmod");
+    
+    int ladder_ok = 1;
+    int fastmod_mismatches = 0;
+    unsigned long long state = 0x9e3779b97f4a7c15ull;
+    
+    // Every size the table grows or shrinks through, plus sizes off the ladder
+    for (int k = 0; k <= 26; k++) {
+        const int base_size = k < 26 ? 53 << k : 1000;
+        uint64_t magic = 0;
+        const int prime = prime_bucket_count(base_size, &magic);
+        if (prime != next_prime(base_size) || magic != fastmod_magic((uint32_t)prime)) {
+            printf("  base size %d: got %d\n", base_size, prime);
+            ladder_ok = 0;
+        }
+        
+        for (int i = 0; i < 100000; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            const uint32_t a = i < 4 ? (uint32_t)(UINT32_MAX - i) : (uint32_t)state;
+            if (fastmod(a, magic, (uint32_t)prime) != a % (uint32_t)prime) {
+                fastmod_mismatches++;
+            }
+        }
+    }
+    
+    print_test_result("Ladder sizes match next_prime", ladder_ok);
+    print_test_result("fastmod matches % for 2.7M values", fastmod_mismatches == 0);
+}
+
 int main(void) {
     printf("\n");
     printf("╔════════════════════════════════════════╗\n");
@@ -278,6 +613,27 @@ int main(void) {
     print_separator();
     
     test_edge_cases();
+    print_separator();
+    
+    test_url_keys();
+    print_separator();
+    
+    test_churn();
+    print_separator();
+    
+    test_incremental_resize();
+    print_separator();
+    
+    test_batch();
+    print_separator();
+    
+    test_tombstones();
+    print_separator();
+    
+    test_binary_keys();
+    print_separator();
+    
+    test_prime_ladder();
     
     printf("\n");
     printf("╔════════════════════════════════════════╗\n");
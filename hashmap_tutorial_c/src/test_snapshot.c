@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "hash_table.h"
+
+#define SNAPSHOT_PATH "build/test_snapshot.bin"
+#define NUM_KEYS 5000
+
+// Helper function to print test results
+void print_test_header(const char* test_name) {
+    printf("\n========================================\n");
+    printf("TEST: %s\n", test_name);
+    printf("========================================\n");
+}
+
+void print_test_result(const char* description, int passed) {
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+}
+
+// Save a table, map it back and check every lookup path against it
+void test_round_trip() {
+    print_test_header("Save and Map a Snapshot");
+
+    ht_hash_table* ht = ht_new_incremental();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+
+    char key[32], value[32];
+    for (int i = 0; i < NUM_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        sprintf(value, "value_%d", i);
+        ht_insert(ht, key, value);
+    }
+    for (int i = 0; i < NUM_KEYS; i += 3) {
+        sprintf(key, "key_%d", i);
+        ht_delete(ht, key);
+    }
+
+    // Embedded NULs in both key and value
+    const char bin_key[] = {'b', 0, 'i', 0, 'n'};
+    const char bin_value[] = {0, 1, 2, 0, 3, 4};
+    ht_insert_n(ht, bin_key, sizeof(bin_key), bin_value, sizeof(bin_value), 0);
+    const int expected_count = ht->count;
+
+    print_test_result("Snapshot written", ht_save(ht, SNAPSHOT_PATH) == 0);
+    ht_del_hash_table(ht);
+
+    ht_hash_table* mapped = ht_open_mmap(SNAPSHOT_PATH);
+    print_test_result("Snapshot mapped", mapped != NULL);
+    if (mapped == NULL) {
+        return;
+    }
+    print_test_result("Count preserved", mapped->count == expected_count);
+
+    int errors = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        sprintf(value, "value_%d", i);
+        char* found = ht_search(mapped, key);
+        if (i % 3 == 0 ? found != NULL : (found == NULL || strcmp(found, value) != 0)) {
+            errors++;
+        }
+    }
+    print_test_result("Every key found, deleted keys missing", errors == 0);
+    print_test_result("Unknown key missing", ht_search(mapped, "not_a_key") == NULL);
+
+    size_t value_len = 0;
+    char* found = ht_search_n(mapped, bin_key, sizeof(bin_key), &value_len);
+    print_test_result("Binary key and value survive",
+                      found != NULL && value_len == sizeof(bin_value) &&
+                      memcmp(found, bin_value, sizeof(bin_value)) == 0);
+
+    const char* keys[4] = {"key_1", "key_3", "missing", "key_4999"};
+    char* values[4];
+    ht_search_batch(mapped, keys, 4, values);
+    print_test_result("Batch search on mapped table",
+                      values[0] != NULL && strcmp(values[0], "value_1") == 0 &&
+                      values[1] == NULL && values[2] == NULL &&
+                      values[3] != NULL && strcmp(values[3], "value_4999") == 0);
+
+    // Mapped tables are read-only; writes are refused and change nothing
+    ht_insert(mapped, "key_1", "changed");
+    ht_delete(mapped, "key_2");
+    print_test_result("Writes refused on mapped table",
+                      strcmp(ht_search(mapped, "key_1"), "value_1") == 0 &&
+                      ht_search(mapped, "key_2") != NULL &&
+                      mapped->count == expected_count);
+
+    ht_del_hash_table(mapped);
+}
+
+// Saving over a snapshot that is still mapped replaces the file without
+// touching the mapping
+void test_save_over_mapped() {
+    print_test_header("Save Over a Mapped Snapshot");
+
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    ht_insert(ht, "generation", "first");
+    ht_insert(ht, "only_in_first", "1");
+    int ok = ht_save(ht, SNAPSHOT_PATH) == 0;
+    ht_hash_table* old_map = ok ? ht_open_mmap(SNAPSHOT_PATH) : NULL;
+    print_test_result("First snapshot mapped", old_map != NULL);
+    if (old_map == NULL) {
+        ht_del_hash_table(ht);
+        return;
+    }
+
+    // A bigger table, so an in-place rewrite would also have moved records
+    char key[32];
+    for (int i = 0; i < NUM_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        ht_insert(ht, key, "x");
+    }
+    ht_insert(ht, "generation", "second");
+    ht_delete(ht, "only_in_first");
+    print_test_result("Second snapshot written over the first", ht_save(ht, SNAPSHOT_PATH) == 0);
+    ht_del_hash_table(ht);
+
+    const char* gen = ht_search(old_map, "generation");
+    print_test_result("Old mapping still reads the first snapshot",
+                      gen != NULL && strcmp(gen, "first") == 0 &&
+                      ht_search(old_map, "only_in_first") != NULL);
+    ht_del_hash_table(old_map);
+
+    ht_hash_table* new_map = ht_open_mmap(SNAPSHOT_PATH);
+    gen = new_map != NULL ? ht_search(new_map, "generation") : NULL;
+    print_test_result("New mapping reads the second snapshot",
+                      gen != NULL && strcmp(gen, "second") == 0 &&
+                      ht_search(new_map, "only_in_first") == NULL);
+    if (new_map != NULL) ht_del_hash_table(new_map);
+
+    FILE* tmp = fopen(SNAPSHOT_PATH ".tmp", "rb");
+    print_test_result("No temporary file left behind", tmp == NULL);
+    if (tmp != NULL) fclose(tmp);
+    remove(SNAPSHOT_PATH);
+}
+
+// Byte offsets into a snapshot: header fields, the slot array, and the
+// key_len field and key bytes of a record
+#define SNAP_COUNT 24
+#define SNAP_FILE_SIZE 32
+#define SNAP_SLOTS 40
+#define SNAP_REC_KEY_LEN 8
+#define SNAP_REC_KEY 24
+#define CORRUPT_KEYS 100
+
+static uint64_t snap_get(const unsigned char* data, size_t off) {
+    uint64_t v;
+    memcpy(&v, data + off, sizeof(v));
+    return v;
+}
+
+static void snap_put(unsigned char* data, size_t off, uint64_t v) {
+    memcpy(data + off, &v, sizeof(v));
+}
+
+// Writes `len` bytes of a damaged copy and reports whether the damage was
+// contained: the file is refused at open, or it opens and every lookup
+// either finds its own value or misses, with `damaged_key` missing
+static int snap_contained(const unsigned char* data, size_t len, const char* damaged_key) {
+    FILE* f = fopen(SNAPSHOT_PATH, "wb");
+    if (f == NULL) return 0;
+    fwrite(data, 1, len, f);
+    fclose(f);
+
+    ht_hash_table* ht = ht_open_mmap(SNAPSHOT_PATH);
+    if (ht == NULL) return 1;
+
+    int ok = 1;
+    char key[32];
+    for (int i = 0; i < CORRUPT_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        const char* value = ht_search(ht, key);
+        if (value != NULL && strcmp(value, "value") != 0) ok = 0;
+    }
+    if (damaged_key != NULL && ht_search(ht, damaged_key) != NULL) ok = 0;
+    ht_del_hash_table(ht);
+    return ok;
+}
+
+// Damage a real snapshot in the ways a torn write or bad disk would. Open
+// only checks the header, so damage past it must be caught by the lookups
+// that reach it rather than read outside the mapping.
+void test_corrupt_files() {
+    print_test_header("Reject Truncated and Corrupted Snapshots");
+
+    ht_hash_table* ht = ht_new();
+    if (ht == NULL) {
+        printf("Failed to create hash table\n");
+        return;
+    }
+    char key[32];
+    for (int i = 0; i < CORRUPT_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        ht_insert(ht, key, "value");
+    }
+    int saved = ht_save(ht, SNAPSHOT_PATH) == 0;
+    ht_del_hash_table(ht);
+
+    unsigned char* good = NULL;
+    size_t len = 0;
+    FILE* f = saved ? fopen(SNAPSHOT_PATH, "rb") : NULL;
+    if (f != NULL) {
+        fseek(f, 0, SEEK_END);
+        len = (size_t)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        good = malloc(len);
+        if (good != NULL && fread(good, 1, len, f) != len) {
+            free(good);
+            good = NULL;
+        }
+        fclose(f);
+    }
+    print_test_result("Snapshot written and read back", good != NULL);
+    if (good == NULL) return;
+
+    unsigned char* bad = malloc(len);
+    if (bad == NULL) {
+        free(good);
+        return;
+    }
+
+    // The first occupied slot and its record
+    size_t slot = SNAP_SLOTS;
+    while (snap_get(good, slot) == 0) slot += sizeof(uint64_t);
+    const uint64_t rec = snap_get(good, slot);
+    char damaged[32];
+    const uint64_t damaged_len = snap_get(good, rec + SNAP_REC_KEY_LEN);
+    memcpy(damaged, good + rec + SNAP_REC_KEY, damaged_len);
+    damaged[damaged_len] = '\0';
+
+    ht_hash_table* intact = snap_contained(good, len, NULL) ? ht_open_mmap(SNAPSHOT_PATH) : NULL;
+    int hits = 0;
+    for (int i = 0; intact != NULL && i < CORRUPT_KEYS; i++) {
+        sprintf(key, "key_%d", i);
+        hits += ht_search(intact, key) != NULL;
+    }
+    print_test_result("Intact copy opens and finds every key", hits == CORRUPT_KEYS);
+    if (intact != NULL) ht_del_hash_table(intact);
+
+    // The header no longer matches the file size, so open refuses these
+    print_test_result("Truncated file refused at open",
+                      snap_contained(good, len / 2, NULL) && ht_open_mmap(SNAPSHOT_PATH) == NULL);
+
+    // Truncated, with the header rewritten to match, so only the per-record
+    // checks in the lookup can catch it
+    memcpy(bad, good, len);
+    snap_put(bad, SNAP_FILE_SIZE, rec + 8);
+    print_test_result("Truncated file with a matching header", snap_contained(bad, rec + 8, damaged));
+
+    memcpy(bad, good, len);
+    snap_put(bad, slot, rec + 4);
+    print_test_result("Misaligned slot offset", snap_contained(bad, len, damaged));
+
+    memcpy(bad, good, len);
+    snap_put(bad, slot, len);
+    print_test_result("Slot offset past the end", snap_contained(bad, len, damaged));
+
+    memcpy(bad, good, len);
+    snap_put(bad, slot, 8);
+    print_test_result("Slot offset into the header", snap_contained(bad, len, damaged));
+
+    memcpy(bad, good, len);
+    snap_put(bad, rec + SNAP_REC_KEY_LEN, UINT64_MAX - 1);
+    print_test_result("Record key length past the end", snap_contained(bad, len, damaged));
+
+    memcpy(bad, good, len);
+    snap_put(bad, SNAP_COUNT, UINT64_MAX);
+    print_test_result("Count larger than the table refused at open",
+                      snap_contained(bad, len, NULL) && ht_open_mmap(SNAPSHOT_PATH) == NULL);
+
+    free(bad);
+    free(good);
+    remove(SNAPSHOT_PATH);
+}
+
+void test_bad_files() {
+    print_test_header("Reject Bad Snapshot Files");
+
+    print_test_result("Missing file", ht_open_mmap("build/no_such_snapshot.bin") == NULL);
+
+    FILE* f = fopen(SNAPSHOT_PATH, "wb");
+    if (f != NULL) {
+        fputs("definitely not a snapshot", f);
+        fclose(f);
+    }
+    print_test_result("Garbage file", ht_open_mmap(SNAPSHOT_PATH) == NULL);
+    remove(SNAPSHOT_PATH);
+}
+
+int main(void) {
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   HASH TABLE SNAPSHOT TEST SUITE       ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+
+    test_round_trip();
+    test_save_over_mapped();
+    test_bad_files();
+    test_corrupt_files();
+
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   ALL TESTS COMPLETED                  ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("\n");
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bvh.h"
+
+#define BVH_BINS 16
+#define BVH_MIN_LEAF 4
+// Deeper subtrees become (large) leaves, so traversal never outgrows its stack
+#define BVH_MAX_DEPTH 64
+
+typedef struct {
+    float min[3];
+    float max[3];
+} Bounds;
+
+typedef struct {
+    const Sphere *spheres;
+    Bvh *bvh;
+    int max_leaf;
+} Builder;
+
+static float vec_axis(Vec3 v, int axis) {
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+static void bounds_empty(Bounds *b) {
+    for (int a = 0; a < 3; a++) {
+        b->min[a] = INFINITY;
+        b->max[a] = -INFINITY;
+    }
+}
+
+static void bounds_grow_sphere(Bounds *b, const Sphere *s) {
+    for (int a = 0; a < 3; a++) {
+        const float c = vec_axis(s->center, a);
+        b->min[a] = fminf(b->min[a], c - s->radius);
+        b->max[a] = fmaxf(b->max[a], c + s->radius);
+    }
+}
+
+static void bounds_grow(Bounds *b, const Bounds *other) {
+    for (int a = 0; a < 3; a++) {
+        b->min[a] = fminf(b->min[a], other->min[a]);
+        b->max[a] = fmaxf(b->max[a], other->max[a]);
+    }
+}
+
+static float bounds_area(const Bounds *b) {
+    const float dx = b->max[0] - b->min[0];
+    const float dy = b->max[1] - b->min[1];
+    const float dz = b->max[2] - b->min[2];
+    if (dx < 0 || dy < 0 || dz < 0) return 0.0f;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static void make_leaf(BvhNode *node, int first, int count) {
+    node->offset = first;
+    node->count = count;
+}
+
+static void build_node(Builder *b, int node_index, int first, int count, int depth) {
+    Bvh *bvh = b->bvh;
+    int *idx = bvh->indices;
+
+    Bounds bounds, centroids;
+    bounds_empty(&bounds);
+    bounds_empty(&centroids);
+    for (int i = first; i < first + count; i++) {
+        const Sphere *s = &b->spheres[idx[i]];
+        bounds_grow_sphere(&bounds, s);
+        for (int a = 0; a < 3; a++) {
+            centroids.min[a] = fminf(centroids.min[a], vec_axis(s->center, a));
+            centroids.max[a] = fmaxf(centroids.max[a], vec_axis(s->center, a));
+        }
+    }
+
+    BvhNode *node = &bvh->nodes[node_index];
+    for (int a = 0; a < 3; a++) {
+        node->min[a] = bounds.min[a];
+        node->max[a] = bounds.max[a];
+    }
+
+    if (count <= b->max_leaf || depth >= BVH_MAX_DEPTH - 1) {
+        make_leaf(node, first, count);
+        return;
+    }
+
+    // Split along the axis where the centroids spread furthest
+    int axis = 0;
+    for (int a = 1; a < 3; a++) {
+        if (centroids.max[a] - centroids.min[a] > centroids.max[axis] - centroids.min[axis]) {
+            axis = a;
+        }
+    }
+    const float lo = centroids.min[axis];
+    const float extent = centroids.max[axis] - lo;
+    if (extent <= 0.0f) {
+        make_leaf(node, first, count); // all centres coincide
+        return;
+    }
+
+    Bounds bin_bounds[BVH_BINS];
+    int bin_count[BVH_BINS] = {0};
+    for (int i = 0; i < BVH_BINS; i++) {
+        bounds_empty(&bin_bounds[i]);
+    }
+    const float scale = BVH_BINS / extent;
+    for (int i = first; i < first + count; i++) {
+        const Sphere *s = &b->spheres[idx[i]];
+        int bin = (int)((vec_axis(s->center, axis) - lo) * scale);
+        if (bin >= BVH_BINS) bin = BVH_BINS - 1;
+        bin_count[bin]++;
+        bounds_grow_sphere(&bin_bounds[bin], s);
+    }
+
+    // SAH cost of splitting after each bin: sweep from the right for the
+    // right-hand areas, then from the left
+    float right_area[BVH_BINS];
+    int right_count[BVH_BINS];
+    Bounds acc;
+    bounds_empty(&acc);
+    int n = 0;
+    for (int i = BVH_BINS - 1; i > 0; i--) {
+        bounds_grow(&acc, &bin_bounds[i]);
+        n += bin_count[i];
+        right_area[i] = bounds_area(&acc);
+        right_count[i] = n;
+    }
+
+    float best_cost = INFINITY;
+    int best_split = -1;
+    bounds_empty(&acc);
+    n = 0;
+    for (int i = 0; i < BVH_BINS - 1; i++) {
+        bounds_grow(&acc, &bin_bounds[i]);
+        n += bin_count[i];
+        if (n == 0 || right_count[i + 1] == 0) continue;
+        const float cost = bounds_area(&acc) * n + right_area[i + 1] * right_count[i + 1];
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_split = i;
+        }
+    }
+
+    // Relative to one traversal step, testing a sphere costs about the same
+    // as a box, so a split pays off when the children's expected tests beat
+    // testing everything here
+    const float leaf_cost = bounds_area(&bounds) * count;
+    if (best_split < 0 || (best_cost + bounds_area(&bounds) >= leaf_cost && count <= 2 * b->max_leaf)) {
+        make_leaf(node, first, count);
+        return;
+    }
+
+    int mid = first;
+    for (int i = first; i < first + count; i++) {
+        int bin = (int)((vec_axis(b->spheres[idx[i]].center, axis) - lo) * scale);
+        if (bin >= BVH_BINS) bin = BVH_BINS - 1;
+        if (bin <= best_split) {
+            const int tmp = idx[i];
+            idx[i] = idx[mid];
+            idx[mid] = tmp;
+            mid++;
+        }
+    }
+
+    const int left = bvh->num_nodes++;
+    build_node(b, left, first, mid - first, depth + 1);
+    const int right = bvh->num_nodes++;
+    node->offset = right;
+    node->count = 0;
+    build_node(b, right, mid, first + count - mid, depth + 1);
+}
+
+int bvh_build(Bvh *bvh, const Sphere *spheres, int num_spheres, const SphereKernel *kernel) {
+    bvh->num_spheres = num_spheres;
+    bvh->num_nodes = 0;
+    bvh->kernel = kernel;
+    bvh->soa = (SphereSoA){NULL, NULL, NULL, NULL, 0};
+    bvh->nodes = malloc((size_t)(2 * num_spheres + 1) * sizeof(BvhNode));
+    bvh->indices = malloc((size_t)(num_spheres + 1) * sizeof(int));
+    if (bvh->nodes == NULL || bvh->indices == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        bvh_free(bvh);
+        return -1;
+    }
+    for (int i = 0; i < num_spheres; i++) {
+        bvh->indices[i] = i;
+    }
+
+    Builder b = {spheres, bvh, kernel->width > BVH_MIN_LEAF ? kernel->width : BVH_MIN_LEAF};
+    const int root = bvh->num_nodes++;
+    build_node(&b, root, 0, num_spheres, 0);
+
+    if (soa_build(&bvh->soa, spheres, bvh->indices, num_spheres) != 0) {
+        bvh_free(bvh);
+        return -1;
+    }
+    return 0;
+}
+
+void bvh_free(Bvh *bvh) {
+    free(bvh->nodes);
+    free(bvh->indices);
+    soa_free(&bvh->soa);
+    bvh->nodes = NULL;
+    bvh->indices = NULL;
+    bvh->num_nodes = 0;
+}
+
+// Parameter range along the ray's line inside the box, or 0 if it misses.
+// Like intersect_sphere, the whole line counts, not just t >= 0.
+static int hit_box(const BvhNode *node, const float origin[3], const float inv_dir[3],
+                   float best, float *t_near) {
+    // Plain compares rather than fminf/fmaxf, which are library calls
+    // without -ffast-math
+    float t0 = -INFINITY, t1 = INFINITY;
+    for (int a = 0; a < 3; a++) {
+        const float ta = (node->min[a] - origin[a]) * inv_dir[a];
+        const float tb = (node->max[a] - origin[a]) * inv_dir[a];
+        const float lo = ta < tb ? ta : tb;
+        const float hi = ta < tb ? tb : ta;
+        t0 = lo > t0 ? lo : t0;
+        t1 = hi < t1 ? hi : t1;
+    }
+    *t_near = t0;
+    // Boxes wholly behind the origin cannot hold a hit with t > RT_T_MIN
+    return t0 <= t1 && t0 <= best && t1 > RT_T_MIN;
+}
+
+int bvh_closest_hit(const Bvh *bvh, Ray ray, float *t_out, long *tests) {
+    if (bvh->num_spheres == 0) return -1;
+
+    const float origin[3] = {ray.origin.x, ray.origin.y, ray.origin.z};
+    const float inv_dir[3] = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    float best = INFINITY;
+    int hit = -1;
+    long num_tests = 0;
+
+    // Entry distance is kept with each pushed node: `best` may have shrunk
+    // past it by the time the node is popped
+    int stack[BVH_MAX_DEPTH + 1];
+    float stack_t[BVH_MAX_DEPTH + 1];
+    int top = 0;
+    float t_near;
+    if (hit_box(&bvh->nodes[0], origin, inv_dir, best, &t_near)) {
+        stack[top] = 0;
+        stack_t[top++] = t_near;
+    }
+
+    while (top > 0) {
+        top--;
+        if (stack_t[top] > best) continue;
+        const BvhNode *node = &bvh->nodes[stack[top]];
+        if (node->count > 0) {
+            float t;
+            const int pos = bvh->kernel->closest_hit(&bvh->soa, node->offset, node->count, ray, &t);
+            num_tests += node->count;
+            // Ties go to the lower sphere index, as in a linear scan
+            if (pos >= 0 && (t < best || (t == best && bvh->indices[pos] < hit))) {
+                best = t;
+                hit = bvh->indices[pos];
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so `best` tightens early
+        const int left = (int)(node - bvh->nodes) + 1;
+        const int right = node->offset;
+        float t_left, t_right;
+        const int hit_left = hit_box(&bvh->nodes[left], origin, inv_dir, best, &t_left);
+        const int hit_right = hit_box(&bvh->nodes[right], origin, inv_dir, best, &t_right);
+        if (hit_left && hit_right) {
+            const int left_first = t_left <= t_right;
+            stack[top] = left_first ? right : left;
+            stack_t[top++] = left_first ? t_right : t_left;
+            stack[top] = left_first ? left : right;
+            stack_t[top++] = left_first ? t_left : t_right;
+        } else if (hit_left) {
+            stack[top] = left;
+            stack_t[top++] = t_left;
+        } else if (hit_right) {
+            stack[top] = right;
+            stack_t[top++] = t_right;
+        }
+    }
+
+    if (tests != NULL) *tests += num_tests;
+    if (hit >= 0) *t_out = best;
+    return hit;
+}
+
+// Order does not matter here, so children are pushed as found and the
+// search stops at the first leaf with a hit closer than t_max
+int bvh_any_hit(const Bvh *bvh, Ray ray, float t_max, long *tests) {
+    if (bvh->num_spheres == 0) return 0;
+
+    const float origin[3] = {ray.origin.x, ray.origin.y, ray.origin.z};
+    const float inv_dir[3] = {1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    long num_tests = 0;
+    int found = 0;
+
+    int stack[BVH_MAX_DEPTH + 1];
+    int top = 0;
+    float t_near;
+    if (hit_box(&bvh->nodes[0], origin, inv_dir, t_max, &t_near)) {
+        stack[top++] = 0;
+    }
+
+    while (top > 0 && !found) {
+        const BvhNode *node = &bvh->nodes[stack[--top]];
+        if (node->count > 0) {
+            float t;
+            found = bvh->kernel->closest_hit(&bvh->soa, node->offset, node->count, ray, &t) >= 0 && t < t_max;
+            num_tests += node->count;
+            continue;
+        }
+
+        const int left = (int)(node - bvh->nodes) + 1;
+        if (hit_box(&bvh->nodes[node->offset], origin, inv_dir, t_max, &t_near)) {
+            stack[top++] = node->offset;
+        }
+        if (hit_box(&bvh->nodes[left], origin, inv_dir, t_max, &t_near)) {
+            stack[top++] = left;
+        }
+    }
+
+    if (tests != NULL) *tests += num_tests;
+    return found;
+}
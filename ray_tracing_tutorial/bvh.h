@@ -0,0 +1,42 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "rt.h"
+#include "sphere_simd.h"
+
+// Bounding volume hierarchy over a sphere list, built with a binned surface
+// area heuristic and stored as a flat depth-first node array: an interior
+// node's left child is the next node and `offset` is its right child; a
+// leaf covers indices[offset .. offset + count). The spheres are also copied
+// into `soa` in leaf order, so each leaf is one contiguous kernel call.
+typedef struct {
+    float min[3];
+    float max[3];
+    int offset;
+    int count; // 0 for interior nodes
+} BvhNode;
+
+typedef struct {
+    BvhNode *nodes;
+    int num_nodes;
+    int *indices; // sphere indices in leaf order
+    int num_spheres;
+    SphereSoA soa;
+    const SphereKernel *kernel;
+} Bvh;
+
+// Returns 0 on success. Leaves hold up to `kernel->width` spheres (at least
+// 4), so a leaf test is about one pass of the kernel.
+int bvh_build(Bvh *bvh, const Sphere *spheres, int num_spheres, const SphereKernel *kernel);
+void bvh_free(Bvh *bvh);
+
+// Index of the sphere with the smallest intersect_sphere t along the ray,
+// or -1; the same answer as testing every sphere. `*tests` (if non-NULL)
+// is increased by the number of sphere tests made.
+int bvh_closest_hit(const Bvh *bvh, Ray ray, float *t_out, long *tests);
+
+// Whether any sphere is hit with t < t_max, for shadow rays: returns at the
+// first hit found rather than the closest
+int bvh_any_hit(const Bvh *bvh, Ray ray, float t_max, long *tests);
+
+#endif
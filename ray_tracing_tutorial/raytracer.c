@@ -1,151 +1,1378 @@
+#ifndef RT_NO_SDL
 #include <SDL2/SDL.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "rt.h"
+#include "bvh.h"
+#include "scene.h"
+#include "thread_pool.h"
 
-#define WIDTH 800
-#define HEIGHT 600
-#define NUM_THREADS 4
+// Usage: raytracer [--headless] [-o image.ppm|image.png] [--threads N]
+//                  [--scene file | --generate-scene N] [--save-scene file]
+//                  [--spp N] [--aa-threshold T]
+//                  [--animate [frames]] [--buffers 2|3] [--fps N]
+//        raytracer --bench [frames] [--threads N]
+//        raytracer --bench-bvh [max_spheres] | --bench-simd
+// Without a scene the original three spheres are rendered; see scene.h for
+// the file formats.
+// RT_SIMD=scalar|sse2|avx2 overrides the sphere kernel picked from the CPU.
+// Rendering is progressive: each pass adds samples to an accumulation
+// buffer and rewrites the RGB framebuffer from it, so a window (blitted
+// through an SDL texture) shows a first image after one sample per pixel and
+// then refines. With --headless (or a build with -DRT_NO_SDL, for machines
+// without SDL) only the final image is written to the file. --spp sets the
+// most samples a pixel gets, --aa-threshold how noisy it may stay; --spp 1
+// is the old single ray through each pixel's corner.
+// --animate orbits the camera and renders frame after frame into 2 or 3
+// rotating framebuffers (see run_animation), limited to --fps if given and
+// to the display's refresh rate in a window.
+
+#define TILE_SIZE 32
+#define MAX_BOUNCES 5
+// Pass 0 casts one sample per pixel, the next tops pixels up to
+// AA_MIN_SAMPLES, later ones add AA_BATCH each
+#define AA_MIN_SAMPLES 4
+#define AA_BATCH 4
 
 typedef struct {
-    float x, y, z;
-} Vec3;
+    int width;
+    int height;
+    unsigned char *pixels; // width * height * 3 bytes, RGB, rows top to bottom
+} Framebuffer;
 
 typedef struct {
-    Vec3 center;
-    float radius;
-    Vec3 color;
-} Sphere;
+    int x0, y0, x1, y1;
+} Tile;
 
+// Running sums for one pixel. A pixel is retired once the standard error of
+// its mean luminance falls below the threshold, or it reaches the sample cap.
 typedef struct {
-    Vec3 origin;
-    Vec3 direction;
-} Ray;
+    float sum[3];
+    float sum_lum_sq;
+    int samples;
+    int retired;
+} AccumPixel;
 
+// Tiles are handed out from per-thread deques: the owner pops from the
+// tail, idle threads steal from the head. Tiles are coarse enough that a
+// mutex per deque costs nothing measurable.
 typedef struct {
-    int start_row;
-    int end_row;
-    SDL_Renderer *renderer;
-    Sphere *spheres;
-    int num_spheres;
+    Tile *tiles;
+    int head;
+    int tail;
+    pthread_mutex_t lock;
+} TileDeque;
+
+// Rays cast by kind, and the sphere tests they cost
+typedef struct {
+    long primary;
+    long reflection;
+    long shadow;
+    long tests;
+} RayStats;
+
+typedef struct {
+    int id;
+    int num_threads;
+    TileDeque *deques;
+    Framebuffer *fb;
+    const Scene *scene;
+    const Bvh *bvh;
+    AccumPixel *accum;
+    // This pass: samples to add per pixel, the per-pixel cap and the
+    // standard error at which a pixel stops
+    int pass_samples;
+    int max_samples;
+    float threshold;
+    // Stats for the pass
+    long samples;
+    int retired;
+    RayStats rays;
+    // Load-balance stats, summed over all passes
+    double busy_ms;
+    int tiles_rendered;
+    int tiles_stolen;
 } ThreadData;
 
-Vec3 add(Vec3 a, Vec3 b) {
-    return (Vec3){a.x + b.x, a.y + b.y, a.z + b.z};
+// Reference closest-hit search, kept for --bench-bvh to measure against
+static int closest_hit_linear(Ray ray, const Sphere *spheres, int num_spheres, float *t_out) {
+    float t_min = INFINITY;
+    int hit = -1;
+
+    for (int i = 0; i < num_spheres; i++) {
+        float t;
+        if (intersect_sphere(ray, spheres[i], &t) && t < t_min) {
+            t_min = t;
+            hit = i;
+        }
+    }
+    if (hit >= 0) *t_out = t_min;
+    return hit;
 }
 
-Vec3 subtract(Vec3 a, Vec3 b) {
-    return (Vec3){a.x - b.x, a.y - b.y, a.z - b.z};
+// Phong shading of one hit: ambient, plus diffuse and specular for each
+// light the shadow ray reaches. Shadow rays only need to know whether
+// anything is in the way, so they use the any-hit query.
+static Vec3 shade(const Scene *scene, const Bvh *bvh, const Material *m, Vec3 point, Vec3 normal,
+                  Vec3 view_dir, RayStats *stats) {
+    Vec3 color = {scene->ambient.x * m->color.x, scene->ambient.y * m->color.y, scene->ambient.z * m->color.z};
+    for (int i = 0; i < scene->num_lights; i++) {
+        const Light *light = &scene->lights[i];
+        const Vec3 to_light = subtract(light->position, point);
+        const float distance = sqrtf(dot(to_light, to_light));
+        const Vec3 l = multiply(to_light, 1.0f / distance);
+        const float n_dot_l = dot(normal, l);
+        if (n_dot_l <= 0.0f) continue;
+        stats->shadow++;
+        if (bvh_any_hit(bvh, (Ray){point, l}, distance, &stats->tests)) continue;
+
+        const float specular = powf(fmaxf(dot(reflect(multiply(l, -1.0f), normal), view_dir), 0.0f), m->shininess);
+        const float diffuse = m->diffuse * n_dot_l;
+        color.x += light->color.x * (diffuse * m->color.x + m->specular * specular);
+        color.y += light->color.y * (diffuse * m->color.y + m->specular * specular);
+        color.z += light->color.z * (diffuse * m->color.z + m->specular * specular);
+    }
+    return color;
 }
 
-Vec3 multiply(Vec3 a, float t) {
-    return (Vec3){a.x * t, a.y * t, a.z * t};
+// Each hit spawns at most one reflected ray, so the recursion is a loop
+// carrying the fraction of light that still reaches the eye: any bounce
+// count costs no stack or heap. Stops at MAX_BOUNCES or when what is left
+// could not change the pixel.
+Vec3 trace(Ray ray, const Scene *scene, const Bvh *bvh, RayStats *stats) {
+    Vec3 color = {0.0f, 0.0f, 0.0f}; // Background color
+    float weight = 1.0f;
+
+    for (int bounce = 0; bounce <= MAX_BOUNCES && weight > 1.0f / 512.0f; bounce++) {
+        float t;
+        if (bounce == 0) {
+            stats->primary++;
+        } else {
+            stats->reflection++;
+        }
+        const int hit = bvh_closest_hit(bvh, ray, &t, &stats->tests);
+        if (hit < 0) break;
+
+        const Sphere *sphere = &scene->spheres[hit];
+        const Material *m = &scene->materials[sphere->material];
+        const Vec3 point = add(ray.origin, multiply(ray.direction, t));
+        Vec3 normal = multiply(subtract(point, sphere->center), 1.0f / sphere->radius);
+        if (dot(normal, ray.direction) > 0.0f) {
+            normal = multiply(normal, -1.0f); // hit from inside
+        }
+        // Secondary rays start just off the surface so they do not hit it
+        const Vec3 origin = add(point, multiply(normal, RT_T_MIN * 10.0f));
+
+        const Vec3 local = shade(scene, bvh, m, origin, normal, multiply(ray.direction, -1.0f), stats);
+        const float lit = weight * (1.0f - m->reflectivity);
+        color = add(color, multiply(local, lit));
+
+        weight *= m->reflectivity;
+        ray = (Ray){origin, reflect(ray.direction, normal)};
+    }
+    return color;
 }
 
-float dot(Vec3 a, Vec3 b) {
-    return a.x * b.x + a.y * b.y + a.z * b.z;
+static unsigned char to_byte(float c) {
+    if (c <= 0.0f) return 0;
+    if (c >= 1.0f) return 255;
+    return (unsigned char)(c * 255.0f);
 }
 
-Vec3 normalize(Vec3 v) {
-    float len = sqrt(dot(v, v));
-    return (Vec3){v.x / len, v.y / len, v.z / len};
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
 }
 
-int intersect_sphere(Ray ray, Sphere sphere, float *t) {
-    Vec3 oc = subtract(ray.origin, sphere.center);
-    float a = dot(ray.direction, ray.direction);
-    float b = 2.0 * dot(oc, ray.direction);
-    float c = dot(oc, oc) - sphere.radius * sphere.radius;
-    float discriminant = b * b - 4 * a * c;
+static float luminance(Vec3 c) {
+    return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
 
-    if (discriminant < 0) {
-        return 0;
-    } else {
-        *t = (-b - sqrt(discriminant)) / (2.0 * a);
-        return 1;
+// Position of sample k inside pixel (x, y), in [0, 1)^2. Sample 0 is the
+// pixel corner; the rest follow the R2 low-discrepancy sequence, shifted by
+// a per-pixel hash so neighbours do not share a pattern. Depends only on
+// (x, y, k), so images do not change with the thread count.
+static void sample_offset(int x, int y, int k, float *ox, float *oy) {
+    if (k == 0) {
+        *ox = *oy = 0.0f;
+        return;
     }
+    uint32_t h = (uint32_t)x * 0x9e3779b1u ^ (uint32_t)y * 0x85ebca77u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    const float fx = (float)(h & 0xffff) / 65536.0f + k * 0.7548776662f;
+    const float fy = (float)(h >> 16) / 65536.0f + k * 0.5698402910f;
+    *ox = fx - floorf(fx);
+    *oy = fy - floorf(fy);
 }
 
-Vec3 trace(Ray ray, Sphere *spheres, int num_spheres) {
-    float t_min = INFINITY;
-    Sphere *hit_sphere = NULL;
+static int converged(const AccumPixel *p, float threshold) {
+    const float n = (float)p->samples;
+    const float mean = luminance((Vec3){p->sum[0], p->sum[1], p->sum[2]}) / n;
+    const float variance = (p->sum_lum_sq - n * mean * mean) / (n - 1.0f);
+    return variance <= threshold * threshold * n;
+}
 
-    for (int i = 0; i < num_spheres; i++) {
-        float t;
-        if (intersect_sphere(ray, spheres[i], &t) && t < t_min) {
-            t_min = t;
-            hit_sphere = &spheres[i];
+// Adds this pass's samples to every unretired pixel of the tile and writes
+// the new means to the framebuffer
+static void render_tile(ThreadData *data, Tile tile) {
+    Framebuffer *fb = data->fb;
+    const Camera *camera = &data->scene->camera;
+    for (int y = tile.y0; y < tile.y1; y++) {
+        unsigned char *row = fb->pixels + (size_t)y * fb->width * 3;
+        AccumPixel *accum = data->accum + (size_t)y * fb->width;
+        for (int x = tile.x0; x < tile.x1; x++) {
+            AccumPixel *p = &accum[x];
+            if (p->retired) continue;
+
+            int target = p->samples + data->pass_samples;
+            if (target > data->max_samples) target = data->max_samples;
+            data->samples += target - p->samples;
+            for (; p->samples < target; p->samples++) {
+                float ox, oy;
+                sample_offset(x, y, p->samples, &ox, &oy);
+                float u = ((float)x + ox) / (float)fb->width;
+                float v = ((float)y + oy) / (float)fb->height;
+                Vec3 color = trace(camera_ray(camera, u, v), data->scene, data->bvh, &data->rays);
+                const float lum = luminance(color);
+                p->sum[0] += color.x;
+                p->sum[1] += color.y;
+                p->sum[2] += color.z;
+                p->sum_lum_sq += lum * lum;
+            }
+
+            const float inv = 1.0f / (float)p->samples;
+            row[x * 3 + 0] = to_byte(p->sum[0] * inv);
+            row[x * 3 + 1] = to_byte(p->sum[1] * inv);
+            row[x * 3 + 2] = to_byte(p->sum[2] * inv);
+            if (p->samples >= data->max_samples ||
+                (p->samples >= AA_MIN_SAMPLES && converged(p, data->threshold))) {
+                p->retired = 1;
+                data->retired++;
+            }
         }
     }
+}
 
-    if (hit_sphere) {
-        return hit_sphere->color;
-    } else {
-        return (Vec3){0.0f, 0.0f, 0.0f}; // Background color
+static int pop_tile(TileDeque *deque, Tile *tile) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *tile = deque->tiles[--deque->tail];
+        found = 1;
     }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
 }
 
+static int steal_tile(TileDeque *deque, Tile *tile) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail > deque->head) {
+        *tile = deque->tiles[deque->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// Each tile is written by exactly one thread, so the framebuffer needs no
+// locking. No tiles are added during a frame, so once the own deque and
+// every victim come up empty the thread is done.
 void *render_thread(void *arg) {
     ThreadData *data = (ThreadData *)arg;
-    for (int y = data->start_row; y < data->end_row; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            float u = (float)x / (float)WIDTH;
-            float v = (float)y / (float)HEIGHT;
-            Ray ray = {(Vec3){0.0f, 0.0f, 0.0f}, normalize((Vec3){u - 0.5f, v - 0.5f, 1.0f})};
-            Vec3 color = trace(ray, data->spheres, data->num_spheres);
-
-            SDL_SetRenderDrawColor(data->renderer, (int)(color.x * 255), (int)(color.y * 255), (int)(color.z * 255), 255);
-            SDL_RenderDrawPoint(data->renderer, x, y);
+    Tile tile;
+    while (1) {
+        int found = pop_tile(&data->deques[data->id], &tile);
+        for (int i = 1; !found && i < data->num_threads; i++) {
+            found = steal_tile(&data->deques[(data->id + i) % data->num_threads], &tile);
+            data->tiles_stolen += found;
         }
+        if (!found) break;
+
+        double start = now_ms();
+        render_tile(data, tile);
+        data->busy_ms += now_ms() - start;
+        data->tiles_rendered++;
     }
     return NULL;
 }
 
-int main(int argc, char *argv[]) {
-    SDL_Init(SDL_INIT_VIDEO);
-    SDL_Window *window = SDL_CreateWindow("Ray Tracer", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, 0);
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+// Splits the frame into tiles (clipped at the right and bottom edges) and
+// deals them out in contiguous runs, so neighbouring tiles start on the same
+// thread and stealing only kicks in when a region turns out to be expensive.
+static int init_deques(TileDeque *deques, int num_threads, int width, int height) {
+    const int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    const int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    const int num_tiles = tiles_x * tiles_y;
 
-    Sphere spheres[] = {
-        {(Vec3){0.0f, 0.0f, -5.0f}, 1.0f, (Vec3){1.0f, 0.0f, 0.0f}},
-        {(Vec3){2.0f, 0.0f, -5.0f}, 1.0f, (Vec3){0.0f, 1.0f, 0.0f}},
-        {(Vec3){-2.0f, 0.0f, -5.0f}, 1.0f, (Vec3){0.0f, 0.0f, 1.0f}}
-    };
-    int num_spheres = sizeof(spheres) / sizeof(spheres[0]);
+    for (int t = 0; t < num_threads; t++) {
+        deques[t].tiles = malloc(((size_t)num_tiles / num_threads + 1) * sizeof(Tile));
+        if (deques[t].tiles == NULL) {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            return -1;
+        }
+        deques[t].head = 0;
+        deques[t].tail = 0;
+        pthread_mutex_init(&deques[t].lock, NULL);
+    }
 
-    pthread_t threads[NUM_THREADS];
-    ThreadData thread_data[NUM_THREADS];
-    int rows_per_thread = HEIGHT / NUM_THREADS;
+    for (int i = 0; i < num_tiles; i++) {
+        const int x0 = (i % tiles_x) * TILE_SIZE;
+        const int y0 = (i / tiles_x) * TILE_SIZE;
+        Tile tile = {x0, y0, x0 + TILE_SIZE < width ? x0 + TILE_SIZE : width,
+                     y0 + TILE_SIZE < height ? y0 + TILE_SIZE : height};
+        TileDeque *deque = &deques[(long)i * num_threads / num_tiles];
+        deque->tiles[deque->tail++] = tile;
+    }
+    // Reversed so the owner, popping from the tail, walks its run in scan
+    // order while thieves take from the far end of it
+    for (int t = 0; t < num_threads; t++) {
+        for (int a = deques[t].head, b = deques[t].tail - 1; a < b; a++, b--) {
+            Tile tmp = deques[t].tiles[a];
+            deques[t].tiles[a] = deques[t].tiles[b];
+            deques[t].tiles[b] = tmp;
+        }
+    }
+    return 0;
+}
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        thread_data[i].start_row = i * rows_per_thread;
-        thread_data[i].end_row = (i + 1) * rows_per_thread;
-        thread_data[i].renderer = renderer;
-        thread_data[i].spheres = spheres;
-        thread_data[i].num_spheres = num_spheres;
-        pthread_create(&threads[i], NULL, render_thread, &thread_data[i]);
+static void free_deques(TileDeque *deques, int num_threads) {
+    for (int t = 0; t < num_threads; t++) {
+        pthread_mutex_destroy(&deques[t].lock);
+        free(deques[t].tiles);
     }
+}
 
-    for (int i = 0; i < NUM_THREADS; i++) {
-        pthread_join(threads[i], NULL);
+int write_ppm(const Framebuffer *fb, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Error: cannot open %s for writing\n", path);
+        return -1;
     }
+    fprintf(f, "P6\n%d %d\n255\n", fb->width, fb->height);
+    size_t bytes = (size_t)fb->width * fb->height * 3;
+    int ok = fwrite(fb->pixels, 1, bytes, f) == bytes;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+static uint32_t crc_table[256];
 
-    SDL_RenderPresent(renderer);
+static void init_crc_table(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
 
-    int running = 1;
+static uint32_t crc32_update(uint32_t crc, const unsigned char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static void put_be32(unsigned char *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static int write_png_chunk(FILE *f, const char *type, const unsigned char *data, uint32_t len) {
+    unsigned char header[8], footer[4];
+    put_be32(header, len);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = crc32_update(0xffffffffu, header + 4, 4);
+    crc = crc32_update(crc, data, len) ^ 0xffffffffu;
+    put_be32(footer, crc);
+    return fwrite(header, 1, 8, f) == 8 && fwrite(data, 1, len, f) == len &&
+           fwrite(footer, 1, 4, f) == 4;
+}
+
+// Writes an 8-bit RGB PNG without a zlib dependency: the image data goes
+// into uncompressed ("stored") deflate blocks, so files are about the size
+// of a PPM but open anywhere.
+int write_png(const Framebuffer *fb, const char *path) {
+    const size_t row_bytes = (size_t)fb->width * 3 + 1; // filter byte + RGB
+    const size_t raw_len = row_bytes * fb->height;
+    const size_t num_blocks = (raw_len + 65534) / 65535;
+    const size_t idat_len = 2 + raw_len + num_blocks * 5 + 4;
+
+    unsigned char *idat = malloc(idat_len);
+    if (idat == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return -1;
+    }
+
+    unsigned char *raw = malloc(raw_len);
+    if (raw == NULL) {
+        free(idat);
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return -1;
+    }
+    for (int y = 0; y < fb->height; y++) {
+        raw[y * row_bytes] = 0; // filter: none
+        memcpy(raw + y * row_bytes + 1, fb->pixels + (size_t)y * fb->width * 3, row_bytes - 1);
+    }
+
+    size_t pos = 0;
+    idat[pos++] = 0x78; // zlib header: deflate, 32K window, no dictionary
+    idat[pos++] = 0x01;
+    uint32_t adler_a = 1, adler_b = 0;
+    for (size_t i = 0; i < raw_len; i++) {
+        adler_a = (adler_a + raw[i]) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    for (size_t off = 0; off < raw_len; off += 65535) {
+        const size_t len = raw_len - off < 65535 ? raw_len - off : 65535;
+        idat[pos++] = off + len == raw_len; // BFINAL, BTYPE = stored
+        idat[pos++] = len & 0xff;
+        idat[pos++] = len >> 8;
+        idat[pos++] = ~len & 0xff;
+        idat[pos++] = (~len >> 8) & 0xff;
+        memcpy(idat + pos, raw + off, len);
+        pos += len;
+    }
+    put_be32(idat + pos, (adler_b << 16) | adler_a);
+    pos += 4;
+    free(raw);
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Error: cannot open %s for writing\n", path);
+        free(idat);
+        return -1;
+    }
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    unsigned char ihdr[13];
+    put_be32(ihdr, fb->width);
+    put_be32(ihdr + 4, fb->height);
+    ihdr[8] = 8;  // bit depth
+    ihdr[9] = 2;  // colour type: RGB
+    ihdr[10] = 0; // compression
+    ihdr[11] = 0; // filter
+    ihdr[12] = 0; // no interlace
+
+    init_crc_table();
+    int ok = fwrite(signature, 1, 8, f) == 8 &&
+             write_png_chunk(f, "IHDR", ihdr, sizeof(ihdr)) &&
+             write_png_chunk(f, "IDAT", idat, (uint32_t)pos) &&
+             write_png_chunk(f, "IEND", NULL, 0);
+    if (fclose(f) != 0) ok = 0;
+    free(idat);
+    return ok ? 0 : -1;
+}
+
+// Picks the format from the extension: .png, anything else is PPM
+int write_image(const Framebuffer *fb, const char *path) {
+    const char *ext = strrchr(path, '.');
+    if (ext != NULL && strcmp(ext, ".png") == 0) {
+        return write_png(fb, path);
+    }
+    return write_ppm(fb, path);
+}
+
+// Per-pixel state for rendering frames of one size, and the pool whose
+// workers render them: each pass is num_threads jobs on the same threads
+typedef struct {
+    int num_threads;
+    ThreadPool *pool;
+    TpFuture *futures;
+    ThreadData *thread_data;
+    TileDeque *deques;
+    AccumPixel *accum;
+    size_t num_pixels;
+} Renderer;
+
+typedef struct {
+    int passes;
+    double ms;
+    long samples;
+    RayStats rays;
+} FrameStats;
+
+static int renderer_init(Renderer *r, int num_threads, int width, int height, const Bvh *bvh,
+                         int max_samples, float threshold) {
+    r->num_threads = num_threads;
+    r->num_pixels = (size_t)width * height;
+    r->pool = tp_create(num_threads, num_threads);
+    r->futures = malloc((size_t)num_threads * sizeof(TpFuture));
+    r->thread_data = calloc((size_t)num_threads, sizeof(ThreadData));
+    r->deques = malloc((size_t)num_threads * sizeof(TileDeque));
+    r->accum = malloc(r->num_pixels * sizeof(AccumPixel));
+    if (r->pool == NULL || r->futures == NULL || r->thread_data == NULL || r->deques == NULL || r->accum == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return -1;
+    }
+    for (int i = 0; i < num_threads; i++) {
+        r->thread_data[i].id = i;
+        r->thread_data[i].num_threads = num_threads;
+        r->thread_data[i].deques = r->deques;
+        r->thread_data[i].bvh = bvh;
+        r->thread_data[i].accum = r->accum;
+        r->thread_data[i].max_samples = max_samples;
+        r->thread_data[i].threshold = threshold;
+    }
+    return 0;
+}
+
+static void renderer_free(Renderer *r) {
+    tp_destroy(r->pool);
+    free(r->futures);
+    free(r->thread_data);
+    free(r->deques);
+    free(r->accum);
+}
+
+// One progressive pass over the whole frame with fresh deques. Returns the
+// wall time in ms, or a negative value if the deques could not be set up.
+static double render_pass(Renderer *r, const Framebuffer *fb, int pass_samples) {
+    if (init_deques(r->deques, r->num_threads, fb->width, fb->height) != 0) {
+        return -1.0;
+    }
+
+    const double start = now_ms();
+    for (int i = 0; i < r->num_threads; i++) {
+        r->thread_data[i].pass_samples = pass_samples;
+        r->thread_data[i].samples = 0;
+        r->thread_data[i].retired = 0;
+        memset(&r->thread_data[i].rays, 0, sizeof(RayStats));
+        tp_submit(r->pool, &r->futures[i], render_thread, &r->thread_data[i]);
+    }
+    for (int i = 0; i < r->num_threads; i++) {
+        tp_wait(r->pool, &r->futures[i]);
+    }
+    const double pass_ms = now_ms() - start;
+    free_deques(r->deques, r->num_threads);
+    return pass_ms;
+}
+
+// Renders `scene` into `fb` in passes until every pixel is retired or has
+// max_samples. `on_pass`, if set, runs after each pass and ends the frame
+// early by returning 0. Returns 0 on success.
+static int render_frame(Renderer *r, Framebuffer *fb, const Scene *scene, int verbose,
+                        int (*on_pass)(void *ctx), void *ctx, FrameStats *stats) {
+    const int max_samples = r->thread_data[0].max_samples;
+    memset(r->accum, 0, r->num_pixels * sizeof(AccumPixel));
+    for (int i = 0; i < r->num_threads; i++) {
+        r->thread_data[i].fb = fb;
+        r->thread_data[i].scene = scene;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    size_t retired = 0;
+    int spp = 0;
+    while (spp < max_samples && retired < r->num_pixels) {
+        const int pass = stats->passes;
+        const int pass_samples = pass == 0 ? 1 : spp < AA_MIN_SAMPLES ? AA_MIN_SAMPLES - spp : AA_BATCH;
+        const double pass_ms = render_pass(r, fb, pass_samples);
+        if (pass_ms < 0.0) {
+            return -1;
+        }
+
+        long pass_total = 0;
+        for (int i = 0; i < r->num_threads; i++) {
+            const RayStats *rays = &r->thread_data[i].rays;
+            pass_total += r->thread_data[i].samples;
+            retired += r->thread_data[i].retired;
+            stats->rays.primary += rays->primary;
+            stats->rays.reflection += rays->reflection;
+            stats->rays.shadow += rays->shadow;
+            stats->rays.tests += rays->tests;
+        }
+        spp += pass_samples;
+        stats->passes++;
+        stats->ms += pass_ms;
+        stats->samples += pass_total;
+        if (verbose) {
+            printf("pass %2d: %3d spp, %8.2f ms, %9ld samples, %7.2f Msamples/s, %5.1f%% of pixels retired\n",
+                   pass, spp < max_samples ? spp : max_samples, pass_ms, pass_total,
+                   pass_total / (pass_ms * 1e3), 100.0 * retired / r->num_pixels);
+        }
+        if (on_pass != NULL && !on_pass(ctx)) break;
+    }
+    return 0;
+}
+
+#ifndef RT_NO_SDL
+typedef struct {
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    const Framebuffer *fb; // what present_pass shows
+    int running;
+} Display;
+
+static int display_open(Display *d, int width, int height, int vsync) {
+    memset(d, 0, sizeof(*d));
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        fprintf(stderr, "Error: SDL_Init failed: %s\n", SDL_GetError());
+        return -1;
+    }
+    d->window = SDL_CreateWindow("Ray Tracer", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width, height, 0);
+    d->renderer = SDL_CreateRenderer(d->window, -1, SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+    d->texture = SDL_CreateTexture(d->renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (d->window == NULL || d->renderer == NULL || d->texture == NULL) {
+        fprintf(stderr, "Error: cannot open a window: %s\n", SDL_GetError());
+        return -1;
+    }
+    d->running = 1;
+    return 0;
+}
+
+// One upload and one copy for the whole frame
+static void display_present(Display *d, const Framebuffer *fb) {
+    SDL_UpdateTexture(d->texture, NULL, fb->pixels, fb->width * 3);
+    SDL_RenderCopy(d->renderer, d->texture, NULL, NULL);
+    SDL_RenderPresent(d->renderer);
+}
+
+static void display_handle(Display *d, const SDL_Event *event) {
+    if (event->type == SDL_QUIT || (event->type == SDL_KEYDOWN && event->key.keysym.sym == SDLK_ESCAPE)) {
+        d->running = 0;
+    }
+}
+
+// Shows each progressive pass as it lands, so the preview refines in place
+static int present_pass(void *ctx) {
+    Display *d = ctx;
+    display_present(d, d->fb);
     SDL_Event event;
-    while (running) {
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                running = 0;
+    while (SDL_PollEvent(&event)) {
+        display_handle(d, &event);
+    }
+    return d->running;
+}
+
+static void display_close(Display *d) {
+    if (d->texture != NULL) SDL_DestroyTexture(d->texture);
+    if (d->renderer != NULL) SDL_DestroyRenderer(d->renderer);
+    if (d->window != NULL) SDL_DestroyWindow(d->window);
+    SDL_Quit();
+}
+#endif
+
+// Animation: a producer thread renders frames into a small ring of
+// framebuffers while the main thread presents finished ones, so frame N + 1
+// is being traced while frame N is on screen. Neither side spins: each
+// waits on the condition variable (the main thread, with a window, on SDL
+// events; the producer posts one per finished frame).
+#define MAX_FRAME_BUFFERS 3
+// The camera circles a point this far ahead of it, a full turn every
+// ORBIT_FRAMES frames
+#define ORBIT_DISTANCE 5.0f
+#define ORBIT_FRAMES 240
+
+typedef enum {
+    FRAME_FREE,
+    FRAME_RENDERING,
+    FRAME_READY
+} FrameState;
+
+typedef struct {
+    Framebuffer fbs[MAX_FRAME_BUFFERS];
+    FrameState state[MAX_FRAME_BUFFERS];
+    int frame[MAX_FRAME_BUFFERS];
+    FrameStats stats[MAX_FRAME_BUFFERS];
+    int num_buffers;
+    int num_frames; // 0 renders until stopped
+    int stop;
+    int done;
+    int error;
+    int notify_sdl;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    Renderer *renderer;
+    const Scene *scene;
+} FramePipeline;
+
+static Vec3 rotate_y(Vec3 v, float c, float s) {
+    return (Vec3){c * v.x + s * v.z, v.y, c * v.z - s * v.x};
+}
+
+static Camera orbit_camera(const Camera *camera, int frame) {
+    const float angle = 2.0f * 3.14159265f * (float)(frame % ORBIT_FRAMES) / ORBIT_FRAMES;
+    const float c = cosf(angle), s = sinf(angle);
+    const Vec3 pivot = add(camera->origin, multiply(normalize(camera->forward), ORBIT_DISTANCE));
+    return (Camera){add(pivot, rotate_y(subtract(camera->origin, pivot), c, s)),
+                    rotate_y(camera->forward, c, s), rotate_y(camera->right, c, s), rotate_y(camera->up, c, s)};
+}
+
+static void *animate_thread(void *arg) {
+    FramePipeline *p = arg;
+    for (int frame = 0; p->num_frames == 0 || frame < p->num_frames; frame++) {
+        pthread_mutex_lock(&p->lock);
+        int b = -1;
+        while (!p->stop) {
+            for (int i = 0; i < p->num_buffers && b < 0; i++) {
+                if (p->state[i] == FRAME_FREE) b = i;
+            }
+            if (b >= 0) break;
+            pthread_cond_wait(&p->changed, &p->lock);
+        }
+        if (p->stop) {
+            pthread_mutex_unlock(&p->lock);
+            break;
+        }
+        p->state[b] = FRAME_RENDERING;
+        pthread_mutex_unlock(&p->lock);
+
+        // A shallow copy: only the camera differs from frame to frame
+        Scene frame_scene = *p->scene;
+        frame_scene.camera = orbit_camera(&p->scene->camera, frame);
+        FrameStats stats;
+        const int failed = render_frame(p->renderer, &p->fbs[b], &frame_scene, 0, NULL, NULL, &stats) != 0;
+
+        pthread_mutex_lock(&p->lock);
+        p->state[b] = failed ? FRAME_FREE : FRAME_READY;
+        p->frame[b] = frame;
+        p->stats[b] = stats;
+        p->error |= failed;
+        p->stop |= failed;
+        pthread_cond_broadcast(&p->changed);
+        pthread_mutex_unlock(&p->lock);
+#ifndef RT_NO_SDL
+        if (p->notify_sdl) {
+            SDL_Event event;
+            memset(&event, 0, sizeof(event));
+            event.type = SDL_USEREVENT;
+            SDL_PushEvent(&event);
+        }
+#endif
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->done = 1;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+#ifndef RT_NO_SDL
+    if (p->notify_sdl) {
+        SDL_Event event;
+        memset(&event, 0, sizeof(event));
+        event.type = SDL_USEREVENT;
+        SDL_PushEvent(&event);
+    }
+#endif
+    return NULL;
+}
+
+// The oldest finished frame's buffer. Otherwise -2 once the producer has
+// finished, or -1 if `wait` is 0.
+static int take_ready_frame(FramePipeline *p, int wait) {
+    pthread_mutex_lock(&p->lock);
+    int b = -1;
+    while (1) {
+        for (int i = 0; i < p->num_buffers; i++) {
+            if (p->state[i] == FRAME_READY && (b < 0 || p->frame[i] < p->frame[b])) b = i;
+        }
+        if (b < 0 && p->done) b = -2;
+        if (b != -1 || !wait) break;
+        pthread_cond_wait(&p->changed, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return b;
+}
+
+static void release_frame(FramePipeline *p, int b) {
+    pthread_mutex_lock(&p->lock);
+    p->state[b] = FRAME_FREE;
+    pthread_cond_broadcast(&p->changed);
+    pthread_mutex_unlock(&p->lock);
+}
+
+static void sleep_ms(double ms) {
+    if (ms <= 0.0) return;
+    struct timespec ts = {(time_t)(ms / 1e3), (long)(fmod(ms, 1e3) * 1e6)};
+    nanosleep(&ts, NULL);
+}
+
+// Renders and presents frames until num_frames are shown (0: until the
+// window is closed), at most max_fps a second if that is set. Every frame
+// is logged with its render time and the interval since the previous one;
+// with a window the title shows the running FPS. With an output path the
+// last frame is written there.
+static int run_animation(Renderer *r, const Scene *scene, int num_buffers, int num_frames, double max_fps,
+                         int headless, const char *output) {
+    FramePipeline p;
+    memset(&p, 0, sizeof(p));
+    p.num_buffers = num_buffers;
+    p.num_frames = num_frames;
+    p.renderer = r;
+    p.scene = scene;
+    p.error = 1; // until the producer is running
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.changed, NULL);
+#ifndef RT_NO_SDL
+    Display display;
+    int display_used = 0;
+#else
+    (void)headless;
+#endif
+    for (int i = 0; i < num_buffers; i++) {
+        p.fbs[i] = (Framebuffer){scene->width, scene->height, calloc(r->num_pixels * 3, 1)};
+        if (p.fbs[i].pixels == NULL) {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            goto cleanup;
+        }
+    }
+
+#ifndef RT_NO_SDL
+    if (!headless) {
+        // display_close also tidies up after a display_open that failed
+        display_used = 1;
+        if (display_open(&display, scene->width, scene->height, 1) != 0) {
+            goto cleanup;
+        }
+        p.notify_sdl = 1;
+    }
+#endif
+
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, animate_thread, &p) != 0) {
+        fprintf(stderr, "Error: cannot start the render thread\n");
+        goto cleanup;
+    }
+    p.error = 0;
+
+    const double start = now_ms();
+    double last_present = start, fps = 0.0, render_total = 0.0;
+    int presented = 0;
+    while (1) {
+        int b;
+#ifndef RT_NO_SDL
+        if (!headless) {
+            // Blocks only while no frame is ready, until the producer posts
+            // one or the user does something; the timeout just bounds how
+            // stale a missed wakeup can get. A frame that is already ready
+            // (one wakeup can drain the events of several) is presented
+            // after merely polling.
+            b = take_ready_frame(&p, 0);
+            SDL_Event event;
+            if (b == -1 ? SDL_WaitEventTimeout(&event, 100) : SDL_PollEvent(&event)) {
+                display_handle(&display, &event);
+                while (SDL_PollEvent(&event)) {
+                    display_handle(&display, &event);
+                }
             }
+            if (!display.running) break;
+            if (b == -1) b = take_ready_frame(&p, 0);
+            if (b == -2) break;
+            if (b < 0) continue;
+        } else
+#endif
+        {
+            b = take_ready_frame(&p, 1);
+            if (b < 0) break;
+        }
+
+        if (max_fps > 0.0) {
+            sleep_ms(last_present + 1e3 / max_fps - now_ms());
         }
+#ifndef RT_NO_SDL
+        if (!headless) {
+            display_present(&display, &p.fbs[b]);
+        }
+#endif
+        const double now = now_ms();
+        const double interval = now - last_present;
+        last_present = now;
+        fps = presented == 0 ? 1e3 / interval : 0.9 * fps + 0.1 * (1e3 / interval);
+        render_total += p.stats[b].ms;
+        presented++;
+        printf("frame %4d: render %8.2f ms, %d passes, %.2f samples/pixel, interval %8.2f ms, %6.1f fps\n",
+               p.frame[b], p.stats[b].ms, p.stats[b].passes, (double)p.stats[b].samples / r->num_pixels,
+               interval, fps);
+#ifndef RT_NO_SDL
+        if (!headless) {
+            char title[96];
+            snprintf(title, sizeof(title), "Ray Tracer - %.1f fps, %.1f ms/frame render", fps, p.stats[b].ms);
+            SDL_SetWindowTitle(display.window, title);
+        }
+#endif
+        if (output != NULL && num_frames > 0 && p.frame[b] == num_frames - 1) {
+            if (write_image(&p.fbs[b], output) != 0) {
+                fprintf(stderr, "Error: failed writing %s\n", output);
+            } else {
+                printf("wrote %s\n", output);
+            }
+        }
+        release_frame(&p, b);
     }
 
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    pthread_mutex_lock(&p.lock);
+    p.stop = 1;
+    pthread_cond_broadcast(&p.changed);
+    pthread_mutex_unlock(&p.lock);
+    pthread_join(producer, NULL);
+
+    const double total_ms = now_ms() - start;
+    if (presented > 0) {
+        printf("animation: %d frames in %.2f s, %.1f fps, %.2f ms/frame render, %d buffers\n", presented,
+               total_ms / 1e3, presented * 1e3 / total_ms, render_total / presented, num_buffers);
+    }
+
+cleanup:
+#ifndef RT_NO_SDL
+    if (display_used) {
+        display_close(&display);
+    }
+#endif
+    for (int i = 0; i < num_buffers; i++) {
+        free(p.fbs[i].pixels);
+    }
+    pthread_cond_destroy(&p.changed);
+    pthread_mutex_destroy(&p.lock);
+    return p.error;
+}
+
+static Ray grid_ray(const Scene *scene, int i, int grid_w, int grid_h) {
+    float u = (float)(i % grid_w) / (float)grid_w;
+    float v = (float)(i / grid_w) / (float)grid_h;
+    return camera_ray(&scene->camera, u, v);
+}
+
+// Rays/second of the linear scan vs. the BVH as the sphere count grows. The
+// linear scan only traces a prefix of the rays at large sizes to bound the
+// run time; every ray it traces must agree with the BVH.
+static int bench_bvh(int max_spheres) {
+    const int grid_w = 320, grid_h = 240, num_rays = grid_w * grid_h;
+
+    printf("%9s %10s %8s %14s %14s %9s %11s %10s\n", "spheres", "build ms", "nodes",
+           "linear Mray/s", "bvh Mray/s", "speedup", "tests/ray", "mismatches");
+    for (int n = 10; n <= max_spheres; n *= 10) {
+        Scene scene;
+        if (scene_generate(&scene, n, 0x9e3779b97f4a7c15ull + n) != 0) {
+            return 1;
+        }
+        const Sphere *spheres = scene.spheres;
+
+        Bvh bvh;
+        double start = now_ms();
+        if (bvh_build(&bvh, spheres, n, sphere_kernel_best()) != 0) {
+            scene_free(&scene);
+            return 1;
+        }
+        const double build_ms = now_ms() - start;
+
+        long tests = 0;
+        long hit_sum = 0;
+        start = now_ms();
+        for (int i = 0; i < num_rays; i++) {
+            float t;
+            hit_sum += bvh_closest_hit(&bvh, grid_ray(&scene, i, grid_w, grid_h), &t, &tests);
+        }
+        const double bvh_ms = now_ms() - start;
+
+        const long budget = 200000000L / n;
+        const int linear_rays = budget < num_rays ? (int)budget : num_rays;
+        int mismatches = 0;
+        start = now_ms();
+        for (int i = 0; i < linear_rays; i++) {
+            float t;
+            hit_sum += closest_hit_linear(grid_ray(&scene, i, grid_w, grid_h), spheres, n, &t);
+        }
+        const double linear_ms = now_ms() - start;
+        for (int i = 0; i < linear_rays; i++) {
+            float t_linear, t_bvh;
+            Ray ray = grid_ray(&scene, i, grid_w, grid_h);
+            mismatches += closest_hit_linear(ray, spheres, n, &t_linear) !=
+                          bvh_closest_hit(&bvh, ray, &t_bvh, NULL);
+        }
+
+        const double linear_rate = linear_rays / (linear_ms * 1e3);
+        const double bvh_rate = num_rays / (bvh_ms * 1e3);
+        printf("%9d %10.2f %8d %14.3f %14.3f %8.1fx %11.1f %10d\n", n, build_ms, bvh.num_nodes,
+               linear_rate, bvh_rate, bvh_rate / linear_rate, (double)tests / num_rays, mismatches);
+        (void)hit_sum;
+        bvh_free(&bvh);
+        scene_free(&scene);
+    }
+    return 0;
+}
+
+// Linear closest-hit scans over n spheres: the AoS reference against each
+// SoA kernel this CPU can run
+static int bench_simd(void) {
+    const int sizes[] = {4, 8, 16, 64, 256, 1024};
+    const int grid_w = 320, grid_h = 240, num_rays = grid_w * grid_h;
+    const SphereKernel *kernels;
+    const int num_kernels = sphere_kernels(&kernels);
+
+    printf("%8s %14s", "spheres", "aos Mray/s");
+    for (int k = 0; k < num_kernels; k++) {
+        printf(" %9s Mray/s", kernels[k].name);
+    }
+    printf("\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const int n = sizes[s];
+        Scene scene;
+        SphereSoA soa;
+        if (scene_generate(&scene, n, 0x2545f4914f6cdd1dull + n) != 0) {
+            return 1;
+        }
+        const Sphere *spheres = scene.spheres;
+        if (soa_build(&soa, spheres, NULL, n) != 0) {
+            scene_free(&scene);
+            return 1;
+        }
+
+        // Enough passes over the grid for ~50M sphere tests per column
+        const int passes = 1 + 50000000 / ((long)num_rays * n);
+        long hit_sum = 0;
+        double start = now_ms();
+        for (int p = 0; p < passes; p++) {
+            for (int i = 0; i < num_rays; i++) {
+                float t;
+                hit_sum += closest_hit_linear(grid_ray(&scene, i, grid_w, grid_h), spheres, n, &t);
+            }
+        }
+        printf("%8d %14.2f", n, (double)passes * num_rays / ((now_ms() - start) * 1e3));
+
+        for (int k = 0; k < num_kernels; k++) {
+            start = now_ms();
+            for (int p = 0; p < passes; p++) {
+                for (int i = 0; i < num_rays; i++) {
+                    float t;
+                    hit_sum += kernels[k].closest_hit(&soa, 0, n, grid_ray(&scene, i, grid_w, grid_h), &t);
+                }
+            }
+            printf(" %16.2f", (double)passes * num_rays / ((now_ms() - start) * 1e3));
+        }
+        printf("\n");
+        (void)hit_sum;
+
+        soa_free(&soa);
+        scene_free(&scene);
+    }
+    return 0;
+}
+
+// Fixed scenes for --bench, rendered at BENCH_WIDTH x BENCH_HEIGHT with
+// up to BENCH_SPP samples
+#define BENCH_WIDTH 400
+#define BENCH_HEIGHT 300
+#define BENCH_SPP 4
+
+typedef struct {
+    const char *name;
+    int spheres; // 0: the default scene, otherwise scene_generate's
+} BenchScene;
+
+static const BenchScene bench_scenes[] = {
+    {"default", 0},
+    {"random-1k", 1000},
+    {"random-100k", 100000},
+};
+
+static uint64_t fnv1a(const unsigned char *data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Traces `scene` once with the scalar kernel on one thread into `pixels`:
+// the image every timed frame must reproduce. Kernels and thread counts may
+// change how fast it comes out but never what comes out, and unlike a stored
+// digest that holds whatever compiler and flags built this binary.
+static int bench_reference(const Scene *scene, unsigned char *pixels) {
+    const SphereKernel *kernels;
+    sphere_kernels(&kernels);
+    Framebuffer fb = {scene->width, scene->height, pixels};
+    Bvh bvh;
+    if (bvh_build(&bvh, scene->spheres, scene->num_spheres, &kernels[0]) != 0) {
+        return -1;
+    }
+    Renderer renderer;
+    int failed = renderer_init(&renderer, 1, scene->width, scene->height, &bvh, BENCH_SPP, 0.01f) != 0;
+    if (!failed) {
+        FrameStats stats;
+        failed = render_frame(&renderer, &fb, scene, 0, NULL, NULL, &stats) != 0;
+    }
+    renderer_free(&renderer);
+    bvh_free(&bvh);
+    return failed ? -1 : 0;
+}
+
+// Renders each bench scene `frames` times. Every frame must match the
+// scalar, single-threaded reference rendered in the same run (a race, an
+// uninitialised read or a kernel that disagrees would not). The checksum is
+// the FNV-1a hash of the image, for comparing runs by eye. Returns non-zero
+// if any image differs.
+static int bench_render(int frames, int num_threads) {
+    int failures = 0;
+    printf("%dx%d, up to %d spp, %d frames per scene, %d threads, %s kernel\n", BENCH_WIDTH, BENCH_HEIGHT,
+           BENCH_SPP, frames, num_threads, sphere_kernel_best()->name);
+    printf("%-12s %8s %9s %10s %9s %10s %11s %11s %10s %-18s %s\n", "scene", "spheres", "setup ms", "build ms",
+           "ms/frame", "Mrays/s", "primary", "secondary", "tests/ray", "checksum", "vs. scalar");
+
+    for (size_t s = 0; s < sizeof(bench_scenes) / sizeof(bench_scenes[0]); s++) {
+        const BenchScene *b = &bench_scenes[s];
+        Scene scene;
+        double start = now_ms();
+        if ((b->spheres > 0 ? scene_generate(&scene, b->spheres, 0x9e3779b97f4a7c15ull)
+                            : scene_default(&scene)) != 0) {
+            return 1;
+        }
+        // Same 4:3 aspect as the scenes' own 800x600, so the camera is unchanged
+        scene.width = BENCH_WIDTH;
+        scene.height = BENCH_HEIGHT;
+        const double setup_ms = now_ms() - start;
+
+        Bvh bvh;
+        start = now_ms();
+        if (bvh_build(&bvh, scene.spheres, scene.num_spheres, sphere_kernel_best()) != 0) {
+            scene_free(&scene);
+            return 1;
+        }
+        const double build_ms = now_ms() - start;
+
+        const size_t image_bytes = (size_t)scene.width * scene.height * 3;
+        Renderer renderer;
+        Framebuffer fb = {scene.width, scene.height, calloc(image_bytes, 1)};
+        unsigned char *reference = calloc(image_bytes, 1);
+        if (fb.pixels == NULL || reference == NULL ||
+            renderer_init(&renderer, num_threads, scene.width, scene.height, &bvh, BENCH_SPP, 0.01f) != 0) {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            return 1;
+        }
+        if (bench_reference(&scene, reference) != 0) {
+            return 1;
+        }
+
+        double render_ms = 0.0;
+        RayStats rays = {0, 0, 0, 0};
+        uint64_t checksum = 0;
+        int matches = 1;
+        for (int f = 0; f < frames; f++) {
+            FrameStats stats;
+            if (render_frame(&renderer, &fb, &scene, 0, NULL, NULL, &stats) != 0) {
+                return 1;
+            }
+            render_ms += stats.ms;
+            rays.primary += stats.rays.primary;
+            rays.reflection += stats.rays.reflection;
+            rays.shadow += stats.rays.shadow;
+            rays.tests += stats.rays.tests;
+            if (f == 0) checksum = fnv1a(fb.pixels, image_bytes);
+            matches &= memcmp(fb.pixels, reference, image_bytes) == 0;
+        }
+
+        const long total_rays = rays.primary + rays.reflection + rays.shadow;
+        const char *status = matches ? "ok" : "DIFFERS";
+        failures += !matches;
+        printf("%-12s %8d %9.2f %10.2f %9.2f %10.2f %11ld %11ld %10.1f %016llx   %s\n", b->name,
+               scene.num_spheres, setup_ms, build_ms, render_ms / frames, total_rays / (render_ms * 1e3),
+               rays.primary / frames, (rays.reflection + rays.shadow) / frames,
+               (double)rays.tests / total_rays, (unsigned long long)checksum, status);
+        // busy_ms accumulates over the renderer's lifetime, so average it
+        // like ms/frame
+        printf("  reflection %ld, shadow %ld per frame; thread busy ms/frame:", rays.reflection / frames,
+               rays.shadow / frames);
+        for (int i = 0; i < num_threads; i++) {
+            printf(" %.1f", renderer.thread_data[i].busy_ms / frames);
+        }
+        printf("\n");
+
+        renderer_free(&renderer);
+        free(reference);
+        free(fb.pixels);
+        bvh_free(&bvh);
+        scene_free(&scene);
+    }
+    return failures != 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *output = NULL;
+    const char *scene_path = NULL;
+    const char *save_path = NULL;
+    int generate = 0;
+    int max_samples = 0;
+    float threshold = 0.01f;
+    int animate = 0;
+    int num_frames = 0;
+    int num_buffers = 2;
+    double max_fps = 0.0;
+    int bench_frames = 0;
+    int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#ifdef RT_NO_SDL
+    int headless = 1;
+#else
+    int headless = 0;
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            scene_path = argv[++i];
+        } else if (strcmp(argv[i], "--generate-scene") == 0 && i + 1 < argc) {
+            generate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--save-scene") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (strcmp(argv[i], "--spp") == 0 && i + 1 < argc) {
+            max_samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--aa-threshold") == 0 && i + 1 < argc) {
+            threshold = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--animate") == 0) {
+            animate = 1;
+            if (i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                num_frames = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--buffers") == 0 && i + 1 < argc) {
+            num_buffers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            max_fps = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            bench_frames = i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9' ? atoi(argv[++i]) : 3;
+        } else if (strcmp(argv[i], "--bench-simd") == 0) {
+            return bench_simd();
+        } else if (strcmp(argv[i], "--bench-bvh") == 0) {
+            return bench_bvh(i + 1 < argc ? atoi(argv[i + 1]) : 100000);
+        } else {
+            fprintf(stderr, "Usage: %s [--headless] [-o image.ppm|image.png] [--threads N] [--scene file | --generate-scene N] [--save-scene file] [--spp N] [--aa-threshold T] [--animate [frames]] [--buffers 2|3] [--fps N] | --bench [frames] [--threads N] | --bench-bvh [max_spheres] | --bench-simd\n", argv[0]);
+            return 1;
+        }
+    }
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if (bench_frames > 0) {
+        return bench_render(bench_frames, num_threads);
+    }
+    if (max_samples < 1) {
+        // Animation wants frames fast, a still wants them clean
+        max_samples = animate ? 1 : 16;
+    }
+    if (num_buffers < 2 || num_buffers > MAX_FRAME_BUFFERS) {
+        num_buffers = 2;
+    }
+    if (animate && headless && num_frames == 0) {
+        num_frames = 60; // nothing would ever stop it otherwise
+    }
+    if (headless && output == NULL) {
+        output = "render.ppm";
+    }
+
+    Scene scene;
+    double start = now_ms();
+    int loaded;
+    if (scene_path != NULL) {
+        loaded = scene_load(&scene, scene_path);
+    } else if (generate > 0) {
+        loaded = scene_generate(&scene, generate, 0x9e3779b97f4a7c15ull);
+    } else {
+        loaded = scene_default(&scene);
+    }
+    if (loaded != 0) {
+        return 1;
+    }
+    printf("scene: %d spheres, %d materials, %dx%d, loaded in %.2f ms%s\n", scene.num_spheres,
+           scene.num_materials, scene.width, scene.height, now_ms() - start, scene.map != NULL ? " (mapped)" : "");
+    if (save_path != NULL) {
+        if (scene_save(&scene, save_path) != 0) {
+            scene_free(&scene);
+            return 1;
+        }
+        printf("wrote %s\n", save_path);
+    }
+
+    Bvh bvh;
+    if (bvh_build(&bvh, scene.spheres, scene.num_spheres, sphere_kernel_best()) != 0) {
+        return 1;
+    }
+    Renderer renderer;
+    if (renderer_init(&renderer, num_threads, scene.width, scene.height, &bvh, max_samples, threshold) != 0) {
+        return 1;
+    }
+
+    if (animate) {
+        const int failed = run_animation(&renderer, &scene, num_buffers, num_frames, max_fps, headless, output);
+        renderer_free(&renderer);
+        bvh_free(&bvh);
+        scene_free(&scene);
+        return failed;
+    }
+
+    Framebuffer fb = {scene.width, scene.height, calloc(renderer.num_pixels * 3, 1)};
+    if (fb.pixels == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return 1;
+    }
+
+    int (*on_pass)(void *) = NULL;
+    void *on_pass_ctx = NULL;
+#ifndef RT_NO_SDL
+    Display display;
+    if (!headless) {
+        if (display_open(&display, fb.width, fb.height, 0) != 0) {
+            return 1;
+        }
+        display.fb = &fb;
+        on_pass = present_pass;
+        on_pass_ctx = &display;
+    }
+#endif
+
+    FrameStats stats;
+    if (render_frame(&renderer, &fb, &scene, 1, on_pass, on_pass_ctx, &stats) != 0) {
+        return 1;
+    }
+    printf("frame 0: %dx%d, %d passes, %.2f ms, %.2f samples/pixel, %.2f Msamples/s, %d threads, %s kernel\n",
+           fb.width, fb.height, stats.passes, stats.ms, (double)stats.samples / renderer.num_pixels,
+           stats.samples / (stats.ms * 1e3), num_threads, bvh.kernel->name);
+    for (int i = 0; i < num_threads; i++) {
+        const ThreadData *d = &renderer.thread_data[i];
+        printf("  thread %2d: busy %7.2f ms, idle %7.2f ms, %3d tiles (%d stolen)\n", i,
+               d->busy_ms, stats.ms - d->busy_ms, d->tiles_rendered, d->tiles_stolen);
+    }
+    renderer_free(&renderer);
+
+    if (output != NULL) {
+        if (write_image(&fb, output) != 0) {
+            fprintf(stderr, "Error: failed writing %s\n", output);
+            free(fb.pixels);
+            return 1;
+        }
+        printf("wrote %s\n", output);
+    }
+
+#ifndef RT_NO_SDL
+    if (!headless) {
+        // Nothing changes any more: sleep in SDL_WaitEvent until the window
+        // is closed
+        SDL_Event event;
+        while (display.running && SDL_WaitEvent(&event)) {
+            display_handle(&display, &event);
+        }
+        display_close(&display);
+    }
+#endif
 
+    bvh_free(&bvh);
+    scene_free(&scene);
+    free(fb.pixels);
     return 0;
 }
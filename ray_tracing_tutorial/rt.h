@@ -0,0 +1,76 @@
+#ifndef RT_H
+#define RT_H
+
+#include <math.h>
+
+// Types and vector math shared by the ray tracer's translation units
+
+typedef struct {
+    float x, y, z;
+} Vec3;
+
+typedef struct {
+    Vec3 center;
+    float radius;
+    int material; // index into the scene's materials
+} Sphere;
+
+typedef struct {
+    Vec3 origin;
+    Vec3 direction;
+} Ray;
+
+static inline Vec3 add(Vec3 a, Vec3 b) {
+    return (Vec3){a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+static inline Vec3 subtract(Vec3 a, Vec3 b) {
+    return (Vec3){a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+static inline Vec3 multiply(Vec3 a, float t) {
+    return (Vec3){a.x * t, a.y * t, a.z * t};
+}
+
+static inline float dot(Vec3 a, Vec3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline Vec3 cross(Vec3 a, Vec3 b) {
+    return (Vec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// Mirror image of `d` about the plane with unit normal `n`
+static inline Vec3 reflect(Vec3 d, Vec3 n) {
+    return subtract(d, multiply(n, 2.0f * dot(d, n)));
+}
+
+static inline Vec3 normalize(Vec3 v) {
+    float len = sqrtf(dot(v, v));
+    return (Vec3){v.x / len, v.y / len, v.z / len};
+}
+
+// Hits closer than this are the surface a secondary ray starts from
+#define RT_T_MIN 1e-4f
+
+// Nearest t > RT_T_MIN where the ray meets the sphere: the near root, or the
+// far one when the ray starts inside. All float: double literals or sqrt()
+// would widen every step to double.
+static inline int intersect_sphere(Ray ray, Sphere sphere, float *t) {
+    Vec3 oc = subtract(ray.origin, sphere.center);
+    float a = dot(ray.direction, ray.direction);
+    float b = 2.0f * dot(oc, ray.direction);
+    float c = dot(oc, oc) - sphere.radius * sphere.radius;
+    float discriminant = b * b - 4.0f * a * c;
+
+    if (discriminant < 0.0f) {
+        return 0;
+    }
+    float root = sqrtf(discriminant);
+    float near = (-b - root) / (2.0f * a);
+    float far = (-b + root) / (2.0f * a);
+    *t = near > RT_T_MIN ? near : far;
+    return *t > RT_T_MIN;
+}
+
+#endif
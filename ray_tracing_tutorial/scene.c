@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scene.h"
+
+#define SCENE_MAGIC "RTSCENE1"
+#define SCENE_VERSION 2
+#define SCENE_ENDIAN 0x01020304u
+#define SCENE_NAME_LEN 32
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian; // SCENE_ENDIAN as written by the host that saved it
+    int32_t width;
+    int32_t height;
+    Camera camera;
+    Vec3 ambient;
+    uint32_t num_lights;
+    uint32_t num_materials;
+    uint32_t num_spheres;
+    uint64_t lights_offset;
+    uint64_t materials_offset;
+    uint64_t spheres_offset;
+} SceneFileHeader;
+
+static const float PI = 3.14159265358979f;
+
+void camera_look_at(Camera *camera, Vec3 origin, Vec3 target, float fov_x_deg, float fov_y_deg,
+                    int width, int height) {
+    const Vec3 forward = normalize(subtract(target, origin));
+    Vec3 world_up = {0.0f, 1.0f, 0.0f};
+    if (fabsf(dot(forward, world_up)) > 0.999f) {
+        world_up = (Vec3){0.0f, 0.0f, 1.0f};
+    }
+    const Vec3 right = normalize(cross(forward, world_up));
+    const Vec3 up = cross(right, forward);
+
+    const float half_x = tanf(fov_x_deg * PI / 360.0f);
+    const float half_y = fov_y_deg > 0.0f ? tanf(fov_y_deg * PI / 360.0f) : half_x * height / width;
+    camera->origin = origin;
+    camera->forward = forward;
+    camera->right = multiply(right, 2.0f * half_x);
+    camera->up = multiply(up, 2.0f * half_y);
+}
+
+static void scene_init(Scene *scene) {
+    memset(scene, 0, sizeof(*scene));
+    scene->width = 800;
+    scene->height = 600;
+    // The original field of view, one unit of view plane across at unit
+    // distance, now with square pixels
+    camera_look_at(&scene->camera, (Vec3){0.0f, 0.0f, 0.0f}, (Vec3){0.0f, 0.0f, -1.0f}, 53.13f, 0.0f,
+                   scene->width, scene->height);
+    scene->ambient = (Vec3){0.1f, 0.1f, 0.1f};
+}
+
+
+static Material flat_material(float r, float g, float b) {
+    return (Material){{r, g, b}, 1.0f, 0.0f, 32.0f, 0.0f};
+}
+
+static Material shiny_material(float r, float g, float b, float reflectivity) {
+    return (Material){{r, g, b}, 0.9f, 0.5f, 32.0f, reflectivity};
+}
+
+int scene_default(Scene *scene) {
+    scene_init(scene);
+    scene->owned_lights = malloc(sizeof(Light));
+    scene->owned_materials = malloc(4 * sizeof(Material));
+    scene->owned_spheres = malloc(4 * sizeof(Sphere));
+    if (scene->owned_lights == NULL || scene->owned_materials == NULL || scene->owned_spheres == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        scene_free(scene);
+        return -1;
+    }
+
+    scene->owned_lights[0] = (Light){{5.0f, 5.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+    scene->owned_materials[0] = shiny_material(1.0f, 0.0f, 0.0f, 0.2f);
+    scene->owned_materials[1] = shiny_material(0.0f, 1.0f, 0.0f, 0.2f);
+    scene->owned_materials[2] = shiny_material(0.0f, 0.0f, 1.0f, 0.2f);
+    scene->owned_materials[3] = shiny_material(0.5f, 0.5f, 0.5f, 0.3f);
+    scene->owned_spheres[0] = (Sphere){{0.0f, 0.0f, -5.0f}, 1.0f, 0};
+    scene->owned_spheres[1] = (Sphere){{2.0f, 0.0f, -5.0f}, 1.0f, 1};
+    scene->owned_spheres[2] = (Sphere){{-2.0f, 0.0f, -5.0f}, 1.0f, 2};
+    // Floor: large enough to look flat, small enough to keep float precision
+    scene->owned_spheres[3] = (Sphere){{0.0f, -101.0f, -5.0f}, 100.0f, 3};
+
+    scene->lights = scene->owned_lights;
+    scene->num_lights = 1;
+    scene->materials = scene->owned_materials;
+    scene->num_materials = 4;
+    scene->spheres = scene->owned_spheres;
+    scene->num_spheres = 4;
+    return 0;
+}
+
+// xorshift so generated scenes are repeatable
+static unsigned long long next_rand(unsigned long long *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static float rand_float(unsigned long long *state, float lo, float hi) {
+    return lo + (hi - lo) * (float)(next_rand(state) >> 40) / (float)(1 << 24);
+}
+
+int scene_generate(Scene *scene, int n, unsigned long long seed) {
+    const int num_materials = 16;
+    scene_init(scene);
+    scene->owned_lights = malloc(2 * sizeof(Light));
+    scene->owned_materials = malloc(num_materials * sizeof(Material));
+    scene->owned_spheres = malloc((size_t)(n > 0 ? n : 1) * sizeof(Sphere));
+    if (scene->owned_lights == NULL || scene->owned_materials == NULL || scene->owned_spheres == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        scene_free(scene);
+        return -1;
+    }
+
+    for (int i = 0; i < num_materials; i++) {
+        scene->owned_materials[i] = flat_material(rand_float(&seed, 0, 1), rand_float(&seed, 0, 1),
+                                                  rand_float(&seed, 0, 1));
+        scene->owned_materials[i].specular = rand_float(&seed, 0, 1);
+        scene->owned_materials[i].reflectivity = rand_float(&seed, 0, 0.5f);
+    }
+
+    // Spread between z = -5 and z = -45 across the frustum, sized so the
+    // total volume stays about the same whatever n is
+    const float radius = 0.6f * cbrtf(1000.0f / (n > 0 ? n : 1));
+    for (int i = 0; i < n; i++) {
+        const float z = rand_float(&seed, -45.0f, -5.0f);
+        const float half = -z * 0.5f;
+        Sphere *s = &scene->owned_spheres[i];
+        s->center = (Vec3){rand_float(&seed, -half, half), rand_float(&seed, -half, half), z};
+        s->radius = radius * rand_float(&seed, 0.5f, 1.5f);
+        s->material = (int)(next_rand(&seed) % num_materials);
+    }
+
+    scene->owned_lights[0] = (Light){{10.0f, 20.0f, 0.0f}, {0.7f, 0.7f, 0.7f}};
+    scene->owned_lights[1] = (Light){{-20.0f, 5.0f, -10.0f}, {0.4f, 0.4f, 0.5f}};
+    scene->lights = scene->owned_lights;
+    scene->num_lights = 2;
+    scene->materials = scene->owned_materials;
+    scene->num_materials = num_materials;
+    scene->spheres = scene->owned_spheres;
+    scene->num_spheres = n;
+    return 0;
+}
+
+// Whether `count` elements of `elem_size` bytes starting at `offset` lie
+// inside a file of `size` bytes. Written so that nothing can wrap, whatever
+// the header claims.
+static int section_fits(uint64_t offset, uint64_t count, size_t elem_size, size_t size) {
+    return offset <= size && count <= (size - offset) / elem_size;
+}
+
+static int load_binary(Scene *scene, const char *path, int fd, size_t size) {
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error: cannot map %s\n", path);
+        return -1;
+    }
+
+    const SceneFileHeader *h = map;
+    if (h->version != SCENE_VERSION || h->endian != SCENE_ENDIAN ||
+        h->width <= 0 || h->height <= 0 || h->num_materials == 0 ||
+        h->num_lights > INT32_MAX || h->num_materials > INT32_MAX || h->num_spheres > INT32_MAX ||
+        h->lights_offset % 4 != 0 || h->materials_offset % 4 != 0 || h->spheres_offset % 4 != 0 ||
+        !section_fits(h->lights_offset, h->num_lights, sizeof(Light), size) ||
+        !section_fits(h->materials_offset, h->num_materials, sizeof(Material), size) ||
+        !section_fits(h->spheres_offset, h->num_spheres, sizeof(Sphere), size)) {
+        fprintf(stderr, "Error: %s is not a valid scene for this build\n", path);
+        munmap(map, size);
+        return -1;
+    }
+
+    scene->width = h->width;
+    scene->height = h->height;
+    scene->camera = h->camera;
+    scene->ambient = h->ambient;
+    scene->lights = (const Light *)((const char *)map + h->lights_offset);
+    scene->num_lights = (int)h->num_lights;
+    scene->materials = (const Material *)((const char *)map + h->materials_offset);
+    scene->num_materials = (int)h->num_materials;
+    scene->spheres = (const Sphere *)((const char *)map + h->spheres_offset);
+    scene->num_spheres = (int)h->num_spheres;
+    scene->map = map;
+    scene->map_size = size;
+
+    // One read-only pass, so a corrupt index cannot reach the renderer
+    for (int i = 0; i < scene->num_spheres; i++) {
+        if (scene->spheres[i].material < 0 || scene->spheres[i].material >= scene->num_materials) {
+            fprintf(stderr, "Error: %s: sphere %d has no material %d\n", path, i, scene->spheres[i].material);
+            scene_free(scene);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int find_material(char (*names)[SCENE_NAME_LEN], int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// Appends one element to a heap array, doubling its capacity when full
+static void *grow(void *array, int *capacity, int count, size_t elem_size) {
+    if (count < *capacity) return array;
+    const int new_capacity = *capacity ? *capacity * 2 : 64;
+    void *bigger = realloc(array, (size_t)new_capacity * elem_size);
+    if (bigger != NULL) *capacity = new_capacity;
+    return bigger;
+}
+
+// Reads line by line straight into the scene's arrays; the file is never
+// held in memory as a whole
+static int load_text(Scene *scene, const char *path, FILE *f) {
+    char line[512];
+    char (*names)[SCENE_NAME_LEN] = NULL;
+    int light_capacity = 0, material_capacity = 0, sphere_capacity = 0, name_capacity = 0;
+    int line_no = 0, have_camera = 1, ok = 1;
+    float cam[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f}, fov_x = 53.13f, fov_y = 0.0f;
+
+    while (ok && fgets(line, sizeof(line), f) != NULL) {
+        line_no++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char keyword[32];
+        int consumed = 0;
+        if (sscanf(line, "%31s%n", keyword, &consumed) != 1) continue;
+        const char *rest = line + consumed;
+
+        if (strcmp(keyword, "resolution") == 0) {
+            ok = sscanf(rest, "%d %d", &scene->width, &scene->height) == 2 &&
+                 scene->width > 0 && scene->height > 0;
+        } else if (strcmp(keyword, "camera") == 0) {
+            const int n = sscanf(rest, "%f %f %f %f %f %f %f %f", &cam[0], &cam[1], &cam[2],
+                                 &cam[3], &cam[4], &cam[5], &fov_x, &fov_y);
+            ok = n >= 7;
+            if (n == 7) fov_y = 0;
+            have_camera = 1;
+        } else if (strcmp(keyword, "camera_basis") == 0) {
+            Camera *c = &scene->camera;
+            ok = sscanf(rest, "%f %f %f %f %f %f %f %f %f %f %f %f",
+                        &c->origin.x, &c->origin.y, &c->origin.z, &c->forward.x, &c->forward.y, &c->forward.z,
+                        &c->right.x, &c->right.y, &c->right.z, &c->up.x, &c->up.y, &c->up.z) == 12;
+            have_camera = 0;
+        } else if (strcmp(keyword, "ambient") == 0) {
+            ok = sscanf(rest, "%f %f %f", &scene->ambient.x, &scene->ambient.y, &scene->ambient.z) == 3;
+        } else if (strcmp(keyword, "light") == 0) {
+            Light l;
+            ok = sscanf(rest, "%f %f %f %f %f %f", &l.position.x, &l.position.y, &l.position.z,
+                        &l.color.x, &l.color.y, &l.color.z) == 6;
+            if (ok) {
+                scene->owned_lights = grow(scene->owned_lights, &light_capacity, scene->num_lights, sizeof(Light));
+                ok = scene->owned_lights != NULL;
+            }
+            if (ok) {
+                scene->owned_lights[scene->num_lights++] = l;
+            }
+        } else if (strcmp(keyword, "material") == 0) {
+            char name[SCENE_NAME_LEN];
+            Material m = flat_material(0, 0, 0);
+            const int n = sscanf(rest, "%31s %f %f %f %f %f %f %f", name, &m.color.x, &m.color.y, &m.color.z,
+                                 &m.diffuse, &m.specular, &m.shininess, &m.reflectivity);
+            ok = n == 4 || n == 8;
+            if (ok) {
+                scene->owned_materials = grow(scene->owned_materials, &material_capacity,
+                                              scene->num_materials, sizeof(Material));
+                names = grow(names, &name_capacity, scene->num_materials, SCENE_NAME_LEN);
+                ok = scene->owned_materials != NULL && names != NULL;
+            }
+            if (ok) {
+                strcpy(names[scene->num_materials], name);
+                scene->owned_materials[scene->num_materials++] = m;
+            }
+        } else if (strcmp(keyword, "sphere") == 0) {
+            char name[SCENE_NAME_LEN];
+            Sphere s;
+            ok = sscanf(rest, "%f %f %f %f %31s", &s.center.x, &s.center.y, &s.center.z, &s.radius, name) == 5;
+            if (ok) {
+                s.material = find_material(names, scene->num_materials, name);
+                if (s.material < 0) {
+                    fprintf(stderr, "Error: %s:%d: unknown material '%s'\n", path, line_no, name);
+                    ok = 0;
+                    continue;
+                }
+                scene->owned_spheres = grow(scene->owned_spheres, &sphere_capacity,
+                                            scene->num_spheres, sizeof(Sphere));
+                ok = scene->owned_spheres != NULL;
+            }
+            if (ok) {
+                scene->owned_spheres[scene->num_spheres++] = s;
+            }
+        } else {
+            ok = 0;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Error: %s:%d: cannot parse '%s'\n", path, line_no, keyword);
+        }
+    }
+    free(names);
+
+    if (!ok || ferror(f) || scene->num_materials == 0 || scene->owned_spheres == NULL) {
+        if (ok) fprintf(stderr, "Error: %s has no materials or no spheres\n", path);
+        return -1;
+    }
+    // Resolution may come after the camera, so the look-at is resolved last
+    if (have_camera) {
+        camera_look_at(&scene->camera, (Vec3){cam[0], cam[1], cam[2]}, (Vec3){cam[3], cam[4], cam[5]},
+                       fov_x, fov_y, scene->width, scene->height);
+    }
+    if (scene->num_lights == 0) {
+        scene->owned_lights = malloc(sizeof(Light));
+        if (scene->owned_lights == NULL) {
+            fprintf(stderr, "Error: memory allocation failed\n");
+            return -1;
+        }
+        scene->owned_lights[0] = (Light){scene->camera.origin, {1.0f, 1.0f, 1.0f}};
+        scene->num_lights = 1;
+    }
+    scene->lights = scene->owned_lights;
+    scene->materials = scene->owned_materials;
+    scene->spheres = scene->owned_spheres;
+    return 0;
+}
+
+int scene_load(Scene *scene, const char *path) {
+    scene_init(scene);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        return -1;
+    }
+
+    struct stat st;
+    char magic[8] = {0};
+    int result;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(SceneFileHeader) &&
+        read(fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, SCENE_MAGIC, 8) == 0) {
+        result = load_binary(scene, path, fd, (size_t)st.st_size);
+        close(fd);
+    } else {
+        FILE *f = fdopen(fd, "r");
+        if (f == NULL || fseek(f, 0, SEEK_SET) != 0) {
+            fprintf(stderr, "Error: cannot read %s\n", path);
+            if (f != NULL) fclose(f); else close(fd);
+            return -1;
+        }
+        result = load_text(scene, path, f);
+        fclose(f);
+    }
+
+    if (result != 0) scene_free(scene);
+    return result;
+}
+
+static int save_binary(const Scene *scene, FILE *f) {
+    SceneFileHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SCENE_MAGIC, 8);
+    h.version = SCENE_VERSION;
+    h.endian = SCENE_ENDIAN;
+    h.width = scene->width;
+    h.height = scene->height;
+    h.camera = scene->camera;
+    h.ambient = scene->ambient;
+    h.num_lights = (uint32_t)scene->num_lights;
+    h.num_materials = (uint32_t)scene->num_materials;
+    h.num_spheres = (uint32_t)scene->num_spheres;
+    h.lights_offset = sizeof(h);
+    h.materials_offset = h.lights_offset + (uint64_t)scene->num_lights * sizeof(Light);
+    h.spheres_offset = h.materials_offset + (uint64_t)scene->num_materials * sizeof(Material);
+
+    return fwrite(&h, sizeof(h), 1, f) == 1 &&
+           fwrite(scene->lights, sizeof(Light), (size_t)scene->num_lights, f) == (size_t)scene->num_lights &&
+           fwrite(scene->materials, sizeof(Material), (size_t)scene->num_materials, f) ==
+               (size_t)scene->num_materials &&
+           fwrite(scene->spheres, sizeof(Sphere), (size_t)scene->num_spheres, f) == (size_t)scene->num_spheres;
+}
+
+static int save_text(const Scene *scene, FILE *f) {
+    const Camera *c = &scene->camera;
+    fprintf(f, "resolution %d %d\n", scene->width, scene->height);
+    fprintf(f, "camera_basis %.9g %.9g %.9g  %.9g %.9g %.9g  %.9g %.9g %.9g  %.9g %.9g %.9g\n",
+            c->origin.x, c->origin.y, c->origin.z, c->forward.x, c->forward.y, c->forward.z,
+            c->right.x, c->right.y, c->right.z, c->up.x, c->up.y, c->up.z);
+    fprintf(f, "ambient %.9g %.9g %.9g\n", scene->ambient.x, scene->ambient.y, scene->ambient.z);
+    for (int i = 0; i < scene->num_lights; i++) {
+        const Light *l = &scene->lights[i];
+        fprintf(f, "light %.9g %.9g %.9g  %.9g %.9g %.9g\n", l->position.x, l->position.y, l->position.z,
+                l->color.x, l->color.y, l->color.z);
+    }
+    for (int i = 0; i < scene->num_materials; i++) {
+        const Material *m = &scene->materials[i];
+        fprintf(f, "material m%d %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n", i, m->color.x, m->color.y,
+                m->color.z, m->diffuse, m->specular, m->shininess, m->reflectivity);
+    }
+    for (int i = 0; i < scene->num_spheres; i++) {
+        const Sphere *s = &scene->spheres[i];
+        fprintf(f, "sphere %.9g %.9g %.9g %.9g m%d\n", s->center.x, s->center.y, s->center.z,
+                s->radius, s->material);
+    }
+    return !ferror(f);
+}
+
+int scene_save(const Scene *scene, const char *path) {
+    const char *ext = strrchr(path, '.');
+    const int binary = ext != NULL && strcmp(ext, ".rtsb") == 0;
+    FILE *f = fopen(path, binary ? "wb" : "w");
+    if (f == NULL) {
+        fprintf(stderr, "Error: cannot open %s for writing\n", path);
+        return -1;
+    }
+    int ok = binary ? save_binary(scene, f) : save_text(scene, f);
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "Error: failed writing %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+void scene_free(Scene *scene) {
+    free(scene->owned_lights);
+    free(scene->owned_materials);
+    free(scene->owned_spheres);
+    if (scene->map != NULL) {
+        munmap(scene->map, scene->map_size);
+    }
+    scene->owned_lights = NULL;
+    scene->owned_materials = NULL;
+    scene->owned_spheres = NULL;
+    scene->map = NULL;
+    scene->lights = NULL;
+    scene->num_lights = 0;
+    scene->materials = NULL;
+    scene->spheres = NULL;
+    scene->num_materials = 0;
+    scene->num_spheres = 0;
+}
@@ -0,0 +1,92 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stddef.h>
+#include "rt.h"
+
+// Scene files
+//
+// Text (.scene, anything not ending in .rtsb), one directive per line, '#'
+// starts a comment:
+//
+//   resolution 800 600
+//   camera 0 0 0  0 0 -1  53.13 [fov_y]    origin, look-at point, degrees
+//   ambient 0.1 0.1 0.1
+//   light 5 5 0  1 1 1                     position, colour
+//   material red  1 0 0  [diffuse specular shininess reflectivity]
+//   sphere 0 0 -5  1  red                  centre, radius, material name
+//
+// fov_y defaults to the value that keeps pixels square. `camera_basis` with
+// origin, forward, right and up vectors (12 numbers) sets the camera
+// exactly; the text writer uses it so files round-trip. Without a camera
+// line the camera sits at the origin looking down -z; a scene without
+// lights gets one white light at the camera.
+//
+// Binary (.rtsb): a fixed header followed by the Material and Sphere arrays
+// exactly as they are laid out in memory. scene_load maps it read-only and
+// renders from the mapping, so a large scene is never parsed or copied.
+
+typedef struct {
+    Vec3 color;
+    float diffuse;
+    float specular;
+    float shininess;
+    float reflectivity;
+} Material;
+
+// Point light
+typedef struct {
+    Vec3 position;
+    Vec3 color;
+} Light;
+
+// Primary ray through (u, v) in [0, 1)^2, v growing down the image, is
+// forward + (u - 0.5) * right + (0.5 - v) * up, so right and up carry the
+// field of view
+typedef struct {
+    Vec3 origin;
+    Vec3 forward;
+    Vec3 right;
+    Vec3 up;
+} Camera;
+
+typedef struct {
+    int width;
+    int height;
+    Camera camera;
+    Vec3 ambient;
+    const Light *lights;
+    int num_lights;
+    const Material *materials;
+    int num_materials;
+    const Sphere *spheres;
+    int num_spheres;
+    // Backing storage: heap arrays, or the read-only mapping of a .rtsb file
+    Light *owned_lights;
+    Material *owned_materials;
+    Sphere *owned_spheres;
+    void *map;
+    size_t map_size;
+} Scene;
+
+static inline Ray camera_ray(const Camera *camera, float u, float v) {
+    Vec3 dir = add(add(camera->forward, multiply(camera->right, u - 0.5f)), multiply(camera->up, 0.5f - v));
+    return (Ray){camera->origin, normalize(dir)};
+}
+
+// Points the camera from `origin` at `target`. fov_y <= 0 derives it from
+// fov_x and the aspect ratio.
+void camera_look_at(Camera *camera, Vec3 origin, Vec3 target, float fov_x_deg, float fov_y_deg,
+                    int width, int height);
+
+// The original three spheres, lit, on a floor
+int scene_default(Scene *scene);
+// `n` random spheres filling the default camera's view, 16 materials
+int scene_generate(Scene *scene, int n, unsigned long long seed);
+// Text or binary, told apart by the file's magic. Returns 0 on success.
+int scene_load(Scene *scene, const char *path);
+// Binary if `path` ends in .rtsb, text otherwise
+int scene_save(const Scene *scene, const char *path);
+void scene_free(Scene *scene);
+
+#endif
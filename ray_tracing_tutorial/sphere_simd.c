@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sphere_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RT_X86 1
+#include <immintrin.h>
+#endif
+
+int soa_build(SphereSoA *soa, const Sphere *spheres, const int *order, int count) {
+    const size_t bytes = (size_t)(count > 0 ? count : 1) * sizeof(float);
+    soa->count = count;
+    soa->cx = malloc(bytes);
+    soa->cy = malloc(bytes);
+    soa->cz = malloc(bytes);
+    soa->r2 = malloc(bytes);
+    if (soa->cx == NULL || soa->cy == NULL || soa->cz == NULL || soa->r2 == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        soa_free(soa);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Sphere *s = &spheres[order != NULL ? order[i] : i];
+        soa->cx[i] = s->center.x;
+        soa->cy[i] = s->center.y;
+        soa->cz[i] = s->center.z;
+        soa->r2[i] = s->radius * s->radius;
+    }
+    return 0;
+}
+
+void soa_free(SphereSoA *soa) {
+    free(soa->cx);
+    free(soa->cy);
+    free(soa->cz);
+    free(soa->r2);
+    soa->cx = soa->cy = soa->cz = soa->r2 = NULL;
+    soa->count = 0;
+}
+
+// Reference kernel: intersect_sphere's arithmetic on SoA fields
+static int closest_hit_scalar(const SphereSoA *soa, int first, int count, Ray ray, float *t_out) {
+    const Vec3 d = ray.direction;
+    const float a = dot(d, d);
+    float best = INFINITY;
+    int hit = -1;
+
+    for (int i = first; i < first + count; i++) {
+        const Vec3 oc = {ray.origin.x - soa->cx[i], ray.origin.y - soa->cy[i], ray.origin.z - soa->cz[i]};
+        const float b = 2.0f * dot(oc, d);
+        const float c = dot(oc, oc) - soa->r2[i];
+        const float discriminant = b * b - 4.0f * a * c;
+        if (discriminant < 0.0f) continue;
+        const float root = sqrtf(discriminant);
+        const float near = (-b - root) / (2.0f * a);
+        const float far = (-b + root) / (2.0f * a);
+        const float t = near > RT_T_MIN ? near : far;
+        if (t > RT_T_MIN && t < best) {
+            best = t;
+            hit = i;
+        }
+    }
+    if (hit >= 0) *t_out = best;
+    return hit;
+}
+
+#ifdef RT_X86
+
+// Lane-wise bests reduced to one answer, lowest position on ties
+static int reduce_lanes(const float *t, const int *idx, int width, float *t_out) {
+    float best = INFINITY;
+    int hit = -1;
+    for (int l = 0; l < width; l++) {
+        if (idx[l] >= 0 && (t[l] < best || (t[l] == best && idx[l] < hit))) {
+            best = t[l];
+            hit = idx[l];
+        }
+    }
+    if (hit >= 0) *t_out = best;
+    return hit;
+}
+
+// SSE2 is part of x86-64 but not of every 32-bit x86, so like the AVX2
+// kernel it is compiled for its own target and only offered after a CPU
+// check. SSE2 has no blendv; selects are and/andnot/or.
+__attribute__((target("sse2")))
+static int closest_hit_sse2(const SphereSoA *soa, int first, int count, Ray ray, float *t_out) {
+    const Vec3 d = ray.direction;
+    const float a = dot(d, d);
+    const __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    const __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y), dz = _mm_set1_ps(d.z);
+    const __m128 four_a = _mm_set1_ps(4.0f * a), two_a = _mm_set1_ps(2.0f * a);
+    const __m128 two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps(), sign = _mm_set1_ps(-0.0f);
+    const __m128 t_min = _mm_set1_ps(RT_T_MIN);
+    __m128 best_t = _mm_set1_ps(INFINITY);
+    __m128i best_idx = _mm_set1_epi32(-1);
+    __m128i idx = _mm_add_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3));
+    const __m128i step = _mm_set1_epi32(4);
+    const __m128i end = _mm_set1_epi32(first + count);
+
+    for (int i = first; i < first + count; i += 4) {
+        const int n = first + count - i;
+        __m128 cx, cy, cz, r2;
+        if (n >= 4) {
+            cx = _mm_loadu_ps(soa->cx + i);
+            cy = _mm_loadu_ps(soa->cy + i);
+            cz = _mm_loadu_ps(soa->cz + i);
+            r2 = _mm_loadu_ps(soa->r2 + i);
+        } else {
+            // Tail: copy what is there, the lane mask below ignores the rest
+            float tx[4] = {0}, ty[4] = {0}, tz[4] = {0}, tr[4] = {0};
+            memcpy(tx, soa->cx + i, n * sizeof(float));
+            memcpy(ty, soa->cy + i, n * sizeof(float));
+            memcpy(tz, soa->cz + i, n * sizeof(float));
+            memcpy(tr, soa->r2 + i, n * sizeof(float));
+            cx = _mm_loadu_ps(tx);
+            cy = _mm_loadu_ps(ty);
+            cz = _mm_loadu_ps(tz);
+            r2 = _mm_loadu_ps(tr);
+        }
+
+        const __m128 ocx = _mm_sub_ps(ox, cx), ocy = _mm_sub_ps(oy, cy), ocz = _mm_sub_ps(oz, cz);
+        const __m128 oc_d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+        const __m128 oc_oc = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz));
+        const __m128 b = _mm_mul_ps(two, oc_d);
+        const __m128 c = _mm_sub_ps(oc_oc, r2);
+        const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(four_a, c));
+        const __m128 root = _mm_sqrt_ps(disc), neg_b = _mm_xor_ps(b, sign);
+        const __m128 near = _mm_div_ps(_mm_sub_ps(neg_b, root), two_a);
+        const __m128 far = _mm_div_ps(_mm_add_ps(neg_b, root), two_a);
+        const __m128 use_near = _mm_cmpgt_ps(near, t_min);
+        const __m128 t = _mm_or_ps(_mm_and_ps(use_near, near), _mm_andnot_ps(use_near, far));
+
+        const __m128 in_range = _mm_castsi128_ps(_mm_cmplt_epi32(idx, end));
+        const __m128 valid = _mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpgt_ps(t, t_min));
+        const __m128 take = _mm_and_ps(_mm_and_ps(in_range, valid), _mm_cmplt_ps(t, best_t));
+        best_t = _mm_or_ps(_mm_and_ps(take, t), _mm_andnot_ps(take, best_t));
+        const __m128i take_i = _mm_castps_si128(take);
+        best_idx = _mm_or_si128(_mm_and_si128(take_i, idx), _mm_andnot_si128(take_i, best_idx));
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    float lane_t[4];
+    int lane_idx[4];
+    _mm_storeu_ps(lane_t, best_t);
+    _mm_storeu_si128((__m128i *)lane_idx, best_idx);
+    return reduce_lanes(lane_t, lane_idx, 4, t_out);
+}
+
+// Compiled for AVX2 regardless of the build flags and only called after
+// the CPU check in sphere_kernels(). No FMA: fused multiply-adds would round
+// differently from the scalar reference.
+__attribute__((target("avx2")))
+static int closest_hit_avx2(const SphereSoA *soa, int first, int count, Ray ray, float *t_out) {
+    const Vec3 d = ray.direction;
+    const float a = dot(d, d);
+    const __m256 ox = _mm256_set1_ps(ray.origin.x), oy = _mm256_set1_ps(ray.origin.y), oz = _mm256_set1_ps(ray.origin.z);
+    const __m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y), dz = _mm256_set1_ps(d.z);
+    const __m256 four_a = _mm256_set1_ps(4.0f * a), two_a = _mm256_set1_ps(2.0f * a);
+    const __m256 two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps(), sign = _mm256_set1_ps(-0.0f);
+    const __m256 t_min = _mm256_set1_ps(RT_T_MIN);
+    __m256 best_t = _mm256_set1_ps(INFINITY);
+    __m256i best_idx = _mm256_set1_epi32(-1);
+    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i step = _mm256_set1_epi32(8);
+    const __m256i end = _mm256_set1_epi32(first + count);
+
+    for (int i = first; i < first + count; i += 8) {
+        const int n = first + count - i;
+        const __m256i in_range_i = _mm256_cmpgt_epi32(end, idx);
+        __m256 cx, cy, cz, r2;
+        if (n >= 8) {
+            cx = _mm256_loadu_ps(soa->cx + i);
+            cy = _mm256_loadu_ps(soa->cy + i);
+            cz = _mm256_loadu_ps(soa->cz + i);
+            r2 = _mm256_loadu_ps(soa->r2 + i);
+        } else {
+            // Masked loads never touch memory past the end of the arrays
+            cx = _mm256_maskload_ps(soa->cx + i, in_range_i);
+            cy = _mm256_maskload_ps(soa->cy + i, in_range_i);
+            cz = _mm256_maskload_ps(soa->cz + i, in_range_i);
+            r2 = _mm256_maskload_ps(soa->r2 + i, in_range_i);
+        }
+
+        const __m256 ocx = _mm256_sub_ps(ox, cx), ocy = _mm256_sub_ps(oy, cy), ocz = _mm256_sub_ps(oz, cz);
+        const __m256 oc_d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)),
+                                          _mm256_mul_ps(ocz, dz));
+        const __m256 oc_oc = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)),
+                                           _mm256_mul_ps(ocz, ocz));
+        const __m256 b = _mm256_mul_ps(two, oc_d);
+        const __m256 c = _mm256_sub_ps(oc_oc, r2);
+        const __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(four_a, c));
+        const __m256 root = _mm256_sqrt_ps(disc), neg_b = _mm256_xor_ps(b, sign);
+        const __m256 near = _mm256_div_ps(_mm256_sub_ps(neg_b, root), two_a);
+        const __m256 far = _mm256_div_ps(_mm256_add_ps(neg_b, root), two_a);
+        const __m256 t = _mm256_blendv_ps(far, near, _mm256_cmp_ps(near, t_min, _CMP_GT_OQ));
+
+        const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ),
+                                           _mm256_cmp_ps(t, t_min, _CMP_GT_OQ));
+        const __m256 take = _mm256_and_ps(_mm256_and_ps(_mm256_castsi256_ps(in_range_i), valid),
+                                          _mm256_cmp_ps(t, best_t, _CMP_LT_OQ));
+        best_t = _mm256_blendv_ps(best_t, t, take);
+        best_idx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_idx),
+                                                        _mm256_castsi256_ps(idx), take));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    float lane_t[8];
+    int lane_idx[8];
+    _mm256_storeu_ps(lane_t, best_t);
+    _mm256_storeu_si256((__m256i *)lane_idx, best_idx);
+    return reduce_lanes(lane_t, lane_idx, 8, t_out);
+}
+
+#endif
+
+static SphereKernel available[3];
+static int num_available = 0;
+
+int sphere_kernels(const SphereKernel **kernels) {
+    if (num_available == 0) {
+        int n = 0;
+        available[n++] = (SphereKernel){"scalar", 1, closest_hit_scalar};
+#ifdef RT_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            available[n++] = (SphereKernel){"sse2", 4, closest_hit_sse2};
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            available[n++] = (SphereKernel){"avx2", 8, closest_hit_avx2};
+        }
+#endif
+        num_available = n;
+    }
+    *kernels = available;
+    return num_available;
+}
+
+const SphereKernel *sphere_kernel_best(void) {
+    const SphereKernel *kernels;
+    const int n = sphere_kernels(&kernels);
+    const char *forced = getenv("RT_SIMD");
+    if (forced != NULL) {
+        for (int i = 0; i < n; i++) {
+            if (strcmp(kernels[i].name, forced) == 0) return &kernels[i];
+        }
+        fprintf(stderr, "Error: RT_SIMD=%s is not available, using %s\n", forced, kernels[n - 1].name);
+    }
+    return &kernels[n - 1];
+}
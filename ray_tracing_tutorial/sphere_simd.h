@@ -0,0 +1,37 @@
+#ifndef SPHERE_SIMD_H
+#define SPHERE_SIMD_H
+
+#include "rt.h"
+
+// Spheres in structure-of-arrays form, so a kernel can load the same field
+// of 4 or 8 consecutive spheres with one instruction
+typedef struct {
+    float *cx, *cy, *cz;
+    float *r2; // radius squared
+    int count;
+} SphereSoA;
+
+// Copies `spheres` into `soa`, in `order` if non-NULL. Returns 0 on success.
+int soa_build(SphereSoA *soa, const Sphere *spheres, const int *order, int count);
+void soa_free(SphereSoA *soa);
+
+// Closest hit among soa[first .. first + count): returns the position with
+// the smallest t > RT_T_MIN (lowest position on ties) or -1. Every kernel computes t
+// with the same float operations in the same order as intersect_sphere, so
+// all of them agree with it bit for bit.
+typedef int (*SphereHitFn)(const SphereSoA *soa, int first, int count, Ray ray, float *t_out);
+
+typedef struct {
+    const char *name;
+    int width; // spheres per instruction
+    SphereHitFn closest_hit;
+} SphereKernel;
+
+// Kernels this CPU can run, scalar reference first, widest last
+int sphere_kernels(const SphereKernel **kernels);
+
+// The widest kernel this CPU can run, unless the RT_SIMD environment
+// variable names another (scalar, sse2, avx2)
+const SphereKernel *sphere_kernel_best(void);
+
+#endif
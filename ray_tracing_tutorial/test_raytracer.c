@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rt.h"
+#include "sphere_simd.h"
+#include "bvh.h"
+#include "scene.h"
+
+// Helper function to print test results
+void print_test_header(const char* test_name) {
+    printf("\n========================================\n");
+    printf("TEST: %s\n", test_name);
+    printf("========================================\n");
+}
+
+void print_test_result(const char* description, int passed) {
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+}
+
+static unsigned long long next_rand(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static float rand_float(unsigned long long* state, float lo, float hi) {
+    return lo + (hi - lo) * (float)(next_rand(state) >> 40) / (float)(1 << 24);
+}
+
+static void random_spheres(Sphere* spheres, int n, unsigned long long* state) {
+    for (int i = 0; i < n; i++) {
+        spheres[i].center = (Vec3){rand_float(state, -10, 10), rand_float(state, -10, 10),
+                                   rand_float(state, -30, -2)};
+        spheres[i].radius = rand_float(state, 0.1f, 2.0f);
+        spheres[i].material = 0;
+    }
+}
+
+static Ray random_ray(unsigned long long* state) {
+    Vec3 origin = {rand_float(state, -1, 1), rand_float(state, -1, 1), rand_float(state, -1, 1)};
+    Vec3 dir = {rand_float(state, -1, 1), rand_float(state, -1, 1), rand_float(state, -1, 1)};
+    return (Ray){origin, normalize(dir)};
+}
+
+// Reference: intersect_sphere over the AoS array, first index wins ties
+static int reference_hit(Ray ray, const Sphere* spheres, int n, float* t_out) {
+    float best = INFINITY;
+    int hit = -1;
+    for (int i = 0; i < n; i++) {
+        float t;
+        if (intersect_sphere(ray, spheres[i], &t) && t < best) {
+            best = t;
+            hit = i;
+        }
+    }
+    if (hit >= 0) *t_out = best;
+    return hit;
+}
+
+// Every kernel must return the same sphere and bit-identical t as the
+// scalar reference, including sub-ranges that leave a partial vector
+void test_kernels_match_reference() {
+    print_test_header("SIMD Kernels Match Scalar Reference");
+
+    const SphereKernel* kernels;
+    const int num_kernels = sphere_kernels(&kernels);
+    unsigned long long state = 0x9e3779b97f4a7c15ull;
+    const int sizes[] = {1, 3, 4, 5, 7, 8, 9, 17, 64, 333};
+
+    for (int k = 0; k < num_kernels; k++) {
+        int mismatches = 0, hits = 0, checks = 0;
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            const int n = sizes[s];
+            Sphere spheres[333];
+            SphereSoA soa;
+            random_spheres(spheres, n, &state);
+            if (soa_build(&soa, spheres, NULL, n) != 0) return;
+
+            for (int r = 0; r < 2000; r++) {
+                Ray ray = random_ray(&state);
+                const int first = n > 2 ? (int)(next_rand(&state) % 3) : 0;
+                const int count = n - first;
+                float t_ref = 0, t_k = 0;
+                const int ref = reference_hit(ray, spheres + first, count, &t_ref);
+                const int got = kernels[k].closest_hit(&soa, first, count, ray, &t_k);
+                checks++;
+                if (ref >= 0) hits++;
+                if ((ref < 0) != (got < 0) ||
+                    (ref >= 0 && (got != first + ref || memcmp(&t_ref, &t_k, sizeof(float)) != 0))) {
+                    mismatches++;
+                }
+            }
+            soa_free(&soa);
+        }
+
+        char description[96];
+        sprintf(description, "%s kernel (width %d): %d rays, %d hits, %d mismatches",
+                kernels[k].name, kernels[k].width, checks, hits, mismatches);
+        print_test_result(description, mismatches == 0 && hits > 0);
+    }
+}
+
+// The BVH, whichever kernel its leaves use, finds the same sphere as a
+// linear scan, and its any-hit query agrees on whether a hit lies within a
+// given distance
+void test_bvh_matches_linear() {
+    print_test_header("BVH Matches Linear Scan");
+
+    const SphereKernel* kernels;
+    const int num_kernels = sphere_kernels(&kernels);
+    const int n = 5000;
+    Sphere* spheres = malloc(n * sizeof(Sphere));
+    if (spheres == NULL) {
+        printf("Failed to allocate spheres\n");
+        return;
+    }
+    unsigned long long state = 0xbf58476d1ce4e5b9ull;
+    random_spheres(spheres, n, &state);
+    for (int i = 0; i < n; i++) {
+        spheres[i].radius *= 0.2f;
+    }
+
+    for (int k = 0; k < num_kernels; k++) {
+        Bvh bvh;
+        if (bvh_build(&bvh, spheres, n, &kernels[k]) != 0) break;
+
+        int mismatches = 0, any_mismatches = 0;
+        for (int r = 0; r < 5000; r++) {
+            Ray ray = random_ray(&state);
+            float t_ref = 0, t_bvh = 0;
+            const int ref = reference_hit(ray, spheres, n, &t_ref);
+            const int got = bvh_closest_hit(&bvh, ray, &t_bvh, NULL);
+            if (ref != got || (ref >= 0 && t_ref != t_bvh)) {
+                mismatches++;
+            }
+            const float t_max = rand_float(&state, 0.0f, 40.0f);
+            if (bvh_any_hit(&bvh, ray, t_max, NULL) != (ref >= 0 && t_ref < t_max)) {
+                any_mismatches++;
+            }
+        }
+
+        char description[96];
+        sprintf(description, "BVH with %s leaves: %d mismatches in 5000 rays", kernels[k].name, mismatches);
+        print_test_result(description, mismatches == 0);
+        sprintf(description, "BVH any-hit with %s leaves: %d mismatches in 5000 rays", kernels[k].name,
+                any_mismatches);
+        print_test_result(description, any_mismatches == 0);
+        bvh_free(&bvh);
+    }
+    free(spheres);
+}
+
+static int same_scene(const Scene* a, const Scene* b) {
+    return a->width == b->width && a->height == b->height &&
+           memcmp(&a->camera, &b->camera, sizeof(Camera)) == 0 &&
+           memcmp(&a->ambient, &b->ambient, sizeof(Vec3)) == 0 && a->num_lights == b->num_lights &&
+           memcmp(a->lights, b->lights, a->num_lights * sizeof(Light)) == 0 &&
+           a->num_materials == b->num_materials && a->num_spheres == b->num_spheres &&
+           memcmp(a->materials, b->materials, a->num_materials * sizeof(Material)) == 0 &&
+           memcmp(a->spheres, b->spheres, a->num_spheres * sizeof(Sphere)) == 0;
+}
+
+// Both formats must give back exactly the scene that was saved
+void test_scene_round_trip() {
+    print_test_header("Scene Files Round Trip");
+
+    Scene scene;
+    if (scene_generate(&scene, 1000, 0x94d049bb133111ebull) != 0) return;
+    camera_look_at(&scene.camera, (Vec3){1, 2, 3}, (Vec3){0, 0, -20}, 60.0f, 0.0f, 640, 480);
+    scene.ambient = (Vec3){0.2f, 0.1f, 0.05f};
+    scene.width = 640;
+    scene.height = 480;
+
+    const char* paths[] = {"/tmp/test_raytracer.scene", "/tmp/test_raytracer.rtsb"};
+    for (int p = 0; p < 2; p++) {
+        Scene loaded;
+        int ok = scene_save(&scene, paths[p]) == 0 && scene_load(&loaded, paths[p]) == 0;
+        char description[96];
+        sprintf(description, "%s: 1000 spheres saved and loaded back%s", paths[p],
+                ok && loaded.map != NULL ? " (mapped)" : "");
+        print_test_result(description, ok && same_scene(&scene, &loaded));
+        if (ok) scene_free(&loaded);
+        remove(paths[p]);
+    }
+
+    // Offsets near 2^64 that wrap past the end checks must still be refused
+    unsigned char* bytes = NULL;
+    size_t len = 0;
+    FILE* f = scene_save(&scene, paths[1]) == 0 ? fopen(paths[1], "rb") : NULL;
+    if (f != NULL) {
+        fseek(f, 0, SEEK_END);
+        len = (size_t)ftell(f);
+        fseek(f, 0, SEEK_SET);
+        bytes = malloc(len);
+        if (bytes != NULL && fread(bytes, 1, len, f) != len) {
+            free(bytes);
+            bytes = NULL;
+        }
+        fclose(f);
+    }
+    // The header ends with the three section offsets, and the first of them,
+    // the lights, starts right after it
+    size_t header_size = 0;
+    for (size_t h = 32; bytes != NULL && h <= 512 && h <= len; h += 8) {
+        unsigned long long lights_offset;
+        memcpy(&lights_offset, bytes + h - 24, sizeof(lights_offset));
+        if (lights_offset == h) {
+            header_size = h;
+            break;
+        }
+    }
+    int wrapped_rejected = 0;
+    if (header_size != 0) {
+        const unsigned long long huge = ~0ull - 7;
+        memcpy(bytes + header_size - 8, &huge, sizeof(huge));
+        f = fopen(paths[1], "wb");
+        if (f != NULL) {
+            fwrite(bytes, 1, len, f);
+            fclose(f);
+            Scene wrapped;
+            wrapped_rejected = scene_load(&wrapped, paths[1]) != 0;
+            if (!wrapped_rejected) scene_free(&wrapped);
+        }
+    }
+    print_test_result("Section offset that wraps the end check is rejected", wrapped_rejected);
+    free(bytes);
+    remove(paths[1]);
+    scene_free(&scene);
+
+    // A sphere naming an undefined material is rejected
+    f = fopen(paths[0], "w");
+    if (f == NULL) return;
+    fprintf(f, "material red 1 0 0\nsphere 0 0 -5 1 blue\n");
+    fclose(f);
+    Scene bad;
+    print_test_result("Unknown material name is rejected", scene_load(&bad, paths[0]) != 0);
+    remove(paths[0]);
+}
+
+int main(void) {
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   RAY TRACER TEST SUITE                ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+
+    test_kernels_match_reference();
+    test_bvh_matches_linear();
+    test_scene_round_trip();
+
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   ALL TESTS COMPLETED                  ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("\n");
+
+    return 0;
+}
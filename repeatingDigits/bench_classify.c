@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "repeatingDigits.h"
+#include "classify.h"
+
+// Throughput of classifying arrays of random IDs into a bitmap: a plain
+// loop calling hasRepeatingDigits per value, each kernel on one thread,
+// and the best kernel split across a thread pool
+//
+// Usage: bench_classify [values] [threads]
+
+#define ROUNDS 5
+
+static double nowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t nextRand(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Count of set bits, so every row can be checked against the first
+static long countBits(const uint64_t *bitmap, size_t count)
+{
+    long bits = 0;
+
+    for (size_t w = 0; w < classifyBitmapWords(count); w++)
+    {
+        bits += __builtin_popcountll(bitmap[w]);
+    }
+
+    return bits;
+}
+
+static void printRow(const char *name, double seconds, size_t count, long bits, long expected)
+{
+    printf("%-24s %10.2f %14.0f %s\n", name, seconds / ROUNDS * 1e3, count * ROUNDS / seconds,
+           bits == expected ? "" : "MISMATCH");
+}
+
+int main(int argc, char *argv[])
+{
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    int threads = argc > 2 ? atoi(argv[2]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    uint32_t *values32 = malloc(count * sizeof(uint32_t));
+    int64_t *values64 = malloc(count * sizeof(int64_t));
+    uint64_t *bitmap = malloc(classifyBitmapWords(count) * sizeof(uint64_t));
+    ThreadPool *pool = tp_create(threads, 1024);
+    if (values32 == NULL || values64 == NULL || bitmap == NULL || pool == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    // IDs of every length, the way real ID columns mix them
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        values32[i] = (uint32_t)(nextRand(&state) >> (nextRand(&state) % 32));
+        values64[i] = (int64_t)(nextRand(&state) % 10000000000ULL);
+    }
+
+    const ClassifyKernel *kernels;
+    int numKernels = classifyKernels(&kernels);
+
+    for (int wide = 0; wide <= 1; wide++)
+    {
+        printf("\n%zu %d-bit values, %d rounds\n", count, wide ? 64 : 32, ROUNDS);
+        printf("%-24s %10s %14s\n", "classifier", "ms/round", "values/s");
+
+        // The scalar function, one call per value
+        long expected = 0;
+        double start = nowSeconds();
+        for (int r = 0; r < ROUNDS; r++)
+        {
+            expected = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                expected += wide ? hasRepeatingDigits(values64[i]) : hasRepeatingDigits(values32[i]);
+            }
+        }
+        printRow("hasRepeatingDigits", nowSeconds() - start, count, expected, expected);
+
+        for (int k = 0; k < numKernels; k++)
+        {
+            start = nowSeconds();
+            for (int r = 0; r < ROUNDS; r++)
+            {
+                if (wide)
+                {
+                    kernels[k].classify64(values64, count, bitmap);
+                }
+                else
+                {
+                    kernels[k].classify32(values32, count, bitmap);
+                }
+            }
+            printRow(kernels[k].name, nowSeconds() - start, count, countBits(bitmap, count), expected);
+        }
+
+        char name[32];
+        snprintf(name, sizeof(name), "%s, pool of %d", classifyKernelBest()->name, tp_num_threads(pool));
+        start = nowSeconds();
+        for (int r = 0; r < ROUNDS; r++)
+        {
+            if (wide)
+            {
+                classifyRepeating64(values64, count, bitmap, pool);
+            }
+            else
+            {
+                classifyRepeating32(values32, count, bitmap, pool);
+            }
+        }
+        printRow(name, nowSeconds() - start, count, countBits(bitmap, count), expected);
+    }
+
+    tp_destroy(pool);
+    free(bitmap);
+    free(values64);
+    free(values32);
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include "classify.h"
+#include "repeatingDigits.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RD_X86 1
+#include <immintrin.h>
+#endif
+
+// Smallest chunk handed to a worker, so small inputs are not split up
+#define MIN_CHUNK (1 << 16)
+#define MAX_CHUNKS 256
+
+// Every number above this one has more than ten digits, so repeats one
+#define LARGEST_DISTINCT 9876543210LL
+
+static void classify32Scalar(const uint32_t *values, size_t count, uint64_t *bitmap)
+{
+    for (size_t base = 0; base < count; base += 64)
+    {
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t word = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            word |= (uint64_t)hasRepeatingDigits(values[base + i]) << i;
+        }
+        bitmap[base / 64] = word;
+    }
+}
+
+static void classify64Scalar(const int64_t *values, size_t count, uint64_t *bitmap)
+{
+    for (size_t base = 0; base < count; base += 64)
+    {
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t word = 0;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            word |= (uint64_t)hasRepeatingDigits(values[base + i]) << i;
+        }
+        bitmap[base / 64] = word;
+    }
+}
+
+#ifdef RD_X86
+// Compiled for AVX2 regardless of the build flags and only called after
+// the CPU check in classifyKernels().
+//
+// Division by 10 is a multiply-high: for any 32-bit x,
+// x / 10 == (x * 0xCCCCCCCD) >> 35. AVX2 only multiplies the even 32-bit
+// lanes into 64-bit products, so the odd lanes are shifted down, multiplied
+// separately and blended back. Each round peels one digit off every lane
+// and sets its bit in `seen`; a bit that was already set lands in
+// `repeated`. Lanes that have run out of digits contribute nothing, so
+// there is no per-value branch.
+__attribute__((target("avx2")))
+static inline __m256i repeatedLanes32(__m256i x)
+{
+    const __m256i magic = _mm256_set1_epi32((int)0xCCCCCCCD);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i seen = zero;
+    __m256i repeated = zero;
+
+    // At most ten digits
+    for (int round = 0; round < 10 && !_mm256_testz_si256(x, x); round++)
+    {
+        __m256i qEven = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 35);
+        __m256i qOdd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), 3);
+        // The odd quotients sit in the high half of each 64-bit lane
+        __m256i q = _mm256_blend_epi32(qEven, qOdd, 0xAA);
+
+        __m256i tenQ = _mm256_add_epi32(_mm256_slli_epi32(q, 3), _mm256_slli_epi32(q, 1));
+        __m256i digit = _mm256_sub_epi32(x, tenQ);
+        __m256i live = _mm256_xor_si256(_mm256_cmpeq_epi32(x, zero), _mm256_set1_epi32(-1));
+        __m256i bit = _mm256_and_si256(_mm256_sllv_epi32(one, digit), live);
+
+        repeated = _mm256_or_si256(repeated, _mm256_and_si256(seen, bit));
+        seen = _mm256_or_si256(seen, bit);
+        x = q;
+    }
+
+    return repeated;
+}
+
+__attribute__((target("avx2")))
+static void classify32Avx2(const uint32_t *values, size_t count, uint64_t *bitmap)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (size_t base = 0; base < count; base += 64)
+    {
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t word = 0;
+        size_t i = 0;
+
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(values + base + i));
+            __m256i none = _mm256_cmpeq_epi32(repeatedLanes32(x), zero);
+            uint64_t lanes = ~_mm256_movemask_ps(_mm256_castsi256_ps(none)) & 0xFF;
+            word |= lanes << i;
+        }
+        for (; i < n; i++)
+        {
+            word |= (uint64_t)hasRepeatingDigits(values[base + i]) << i;
+        }
+        bitmap[base / 64] = word;
+    }
+}
+
+// Digits of 32-bit values held in 64-bit lanes; `forced` lanes take zeros
+// as digits until `rounds` have passed, for the low half of a split value
+__attribute__((target("avx2")))
+static inline void accumulateDigits64(__m256i x, __m256i forced, int rounds, __m256i *seen, __m256i *repeated)
+{
+    const __m256i magic = _mm256_set1_epi64x(0xCCCCCCCD);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (int round = 0; round < rounds; round++)
+    {
+        __m256i q = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 35);
+        __m256i tenQ = _mm256_add_epi64(_mm256_slli_epi64(q, 3), _mm256_slli_epi64(q, 1));
+        __m256i digit = _mm256_sub_epi64(x, tenQ);
+        __m256i live = _mm256_or_si256(forced, _mm256_xor_si256(_mm256_cmpeq_epi64(x, zero), _mm256_set1_epi64x(-1)));
+        __m256i bit = _mm256_and_si256(_mm256_sllv_epi64(one, digit), live);
+
+        *repeated = _mm256_or_si256(*repeated, _mm256_and_si256(*seen, bit));
+        *seen = _mm256_or_si256(*seen, bit);
+        x = q;
+    }
+}
+
+// Four 64-bit values at a time. Negative lanes never repeat and lanes above
+// 9876543210 always do; the rest have at most 34 bits, split as
+// high * 100000 + low so both halves fit the 32-bit multiply-high. The
+// split divides by 32 with a shift, then by 3125 as (y * 703687442) >> 41,
+// exact for every y below 2^29.
+__attribute__((target("avx2")))
+static void classify64Avx2(const int64_t *values, size_t count, uint64_t *bitmap)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i largest = _mm256_set1_epi64x(LARGEST_DISTINCT);
+    const __m256i magic3125 = _mm256_set1_epi64x(703687442);
+    const __m256i hundredThousand = _mm256_set1_epi64x(100000);
+
+    for (size_t base = 0; base < count; base += 64)
+    {
+        size_t n = count - base < 64 ? count - base : 64;
+        uint64_t word = 0;
+        size_t i = 0;
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(values + base + i));
+            __m256i negative = _mm256_cmpgt_epi64(zero, x);
+            __m256i tooLong = _mm256_cmpgt_epi64(x, largest);
+            x = _mm256_andnot_si256(_mm256_or_si256(negative, tooLong), x);
+
+            __m256i high = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 5), magic3125), 41);
+            __m256i low = _mm256_sub_epi64(x, _mm256_mul_epu32(high, hundredThousand));
+            __m256i hasHigh = _mm256_xor_si256(_mm256_cmpeq_epi64(high, zero), _mm256_set1_epi64x(-1));
+
+            __m256i seen = zero;
+            __m256i repeated = zero;
+            accumulateDigits64(low, hasHigh, 5, &seen, &repeated);
+            accumulateDigits64(high, zero, 5, &seen, &repeated);
+
+            __m256i hit = _mm256_or_si256(tooLong, _mm256_xor_si256(_mm256_cmpeq_epi64(repeated, zero), _mm256_set1_epi64x(-1)));
+            uint64_t lanes = _mm256_movemask_pd(_mm256_castsi256_pd(hit));
+            word |= lanes << i;
+        }
+        for (; i < n; i++)
+        {
+            word |= (uint64_t)hasRepeatingDigits(values[base + i]) << i;
+        }
+        bitmap[base / 64] = word;
+    }
+}
+#endif
+
+static ClassifyKernel available[2];
+static int numAvailable = 0;
+
+int classifyKernels(const ClassifyKernel **kernels)
+{
+    if (numAvailable == 0)
+    {
+        int n = 0;
+        available[n++] = (ClassifyKernel){"scalar", classify32Scalar, classify64Scalar};
+#ifdef RD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            available[n++] = (ClassifyKernel){"avx2", classify32Avx2, classify64Avx2};
+        }
+#endif
+        numAvailable = n;
+    }
+
+    *kernels = available;
+    return numAvailable;
+}
+
+const ClassifyKernel *classifyKernelBest(void)
+{
+    const ClassifyKernel *kernels;
+    int n = classifyKernels(&kernels);
+
+    return &kernels[n - 1];
+}
+
+// One chunk of a threaded classification
+typedef struct
+{
+    const ClassifyKernel *kernel;
+    const void *values;
+    size_t count;
+    uint64_t *bitmap;
+    int wide;
+} ClassifyJob;
+
+static void *classifyJob(void *arg)
+{
+    ClassifyJob *job = arg;
+
+    if (job->wide)
+    {
+        job->kernel->classify64(job->values, job->count, job->bitmap);
+    }
+    else
+    {
+        job->kernel->classify32(job->values, job->count, job->bitmap);
+    }
+
+    return NULL;
+}
+
+static void classifySplit(const void *values, size_t valueSize, size_t count, uint64_t *bitmap, ThreadPool *pool,
+                          int wide)
+{
+    const ClassifyKernel *kernel = classifyKernelBest();
+    int threads = pool != NULL ? tp_num_threads(pool) : 0;
+
+    // A few chunks per worker evens out their finishing times; every chunk
+    // but the last is a whole number of bitmap words
+    size_t chunks = (size_t)(threads + 1) * 4;
+    if (chunks > MAX_CHUNKS)
+    {
+        chunks = MAX_CHUNKS;
+    }
+    if (chunks > count / MIN_CHUNK)
+    {
+        chunks = count / MIN_CHUNK;
+    }
+    if (threads == 0 || chunks <= 1)
+    {
+        ClassifyJob job = {kernel, values, count, bitmap, wide};
+        classifyJob(&job);
+        return;
+    }
+
+    size_t chunkSize = ((count + chunks - 1) / chunks + 63) / 64 * 64;
+    ClassifyJob jobs[MAX_CHUNKS];
+    TpFuture futures[MAX_CHUNKS];
+    size_t submitted = 0;
+
+    for (size_t first = 0; first < count; first += chunkSize)
+    {
+        ClassifyJob *job = &jobs[submitted];
+        job->kernel = kernel;
+        job->values = (const char *)values + first * valueSize;
+        job->count = count - first < chunkSize ? count - first : chunkSize;
+        job->bitmap = bitmap + first / 64;
+        job->wide = wide;
+        tp_submit(pool, &futures[submitted], classifyJob, job);
+        submitted++;
+    }
+    for (size_t i = 0; i < submitted; i++)
+    {
+        tp_wait(pool, &futures[i]);
+    }
+}
+
+void classifyRepeating32(const uint32_t *values, size_t count, uint64_t *bitmap, ThreadPool *pool)
+{
+    classifySplit(values, sizeof(uint32_t), count, bitmap, pool, 0);
+}
+
+void classifyRepeating64(const int64_t *values, size_t count, uint64_t *bitmap, ThreadPool *pool)
+{
+    classifySplit(values, sizeof(int64_t), count, bitmap, pool, 1);
+}
@@ -0,0 +1,43 @@
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "thread_pool.h"
+
+// Bulk hasRepeatingDigits over arrays of values that are not contiguous
+// ranges. Results go into a bitmap: bit i % 64 of bitmap[i / 64] is set when
+// values[i] has a repeated digit, so the bitmap holds (count + 63) / 64
+// words. Bits past count in the last word are cleared.
+//
+// 32-bit values are unsigned; 64-bit values follow hasRepeatingDigits, so
+// negative numbers never repeat.
+
+// Number of bitmap words for count values
+static inline size_t classifyBitmapWords(size_t count)
+{
+    return (count + 63) / 64;
+}
+
+typedef void (*Classify32Fn)(const uint32_t *values, size_t count, uint64_t *bitmap);
+typedef void (*Classify64Fn)(const int64_t *values, size_t count, uint64_t *bitmap);
+
+typedef struct
+{
+    const char *name;
+    Classify32Fn classify32;
+    Classify64Fn classify64;
+} ClassifyKernel;
+
+// Kernels this CPU can run, slowest (scalar) first. Returns the count.
+int classifyKernels(const ClassifyKernel **kernels);
+// The widest available kernel
+const ClassifyKernel *classifyKernelBest(void);
+
+// Classify with the best kernel, split across the pool's workers in
+// 64-value aligned chunks so no two threads write the same bitmap word.
+// pool may be NULL to run on the calling thread.
+void classifyRepeating32(const uint32_t *values, size_t count, uint64_t *bitmap, ThreadPool *pool);
+void classifyRepeating64(const int64_t *values, size_t count, uint64_t *bitmap, ThreadPool *pool);
+
+#endif
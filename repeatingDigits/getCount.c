@@ -1,64 +1,367 @@
 #include <stdio.h>
-#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "repeatingDigits.h"
 
 // Description: Identify count of numbers with repeating digits between
 // a defined floor and ceiling
-// Input: stdin int floor, stdin int ceiling
+// Input: stdin 64-bit floor, stdin 64-bit ceiling
 // Output: Count of numbers between (inclusive) floor and ceiling which
 // have at least one digit repeated
+//
+// Batch mode: getCount --batch [file]
+// Input: whitespace separated floor/ceiling pairs, one pair per line by
+// convention, from the file or stdin
+// Output: one count per line on stdout, in input order; the query rate
+// goes to stderr
 
-// Check if a number has repeating digits using a bitmask
-int hasRepeatingDigits(int num)
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+// Read size for pipes and terminals: a pipe's default capacity
+#define INPUT_BUFFER_SIZE (1 << 16)
+
+// Input bytes: a regular file mapped whole, or a window of a stream that
+// refillInput slides forward
+typedef struct
 {
-    // Initialize bitmask
-    // Visualization:
-    // 0000000000 : 9876543210
-    // 0000000100 : 2 is present
-    int digitMask = 0;
+    int fd;
+    char *data;
+    size_t size;
+    size_t capacity;
+    int mapped;
+    int eof;
+} Input;
 
-    while (num > 0)
-    {
-        // Get current focus digit
-        int digit = num % 10;
-        // Create bitmask for digit via binary shift
-        int digitBit = 1 << digit;
+// All output goes through one buffer and leaves in large writes
+typedef struct
+{
+    char data[OUTPUT_BUFFER_SIZE];
+    size_t used;
+} Output;
 
-        // Check if digit has already been seen (bit is set in digitMask)
-        if (digitMask & digitBit)
+static int openInput(Input *input, int fd)
+{
+    struct stat info;
+
+    input->fd = fd;
+    input->data = NULL;
+    input->size = 0;
+    input->capacity = 0;
+    input->mapped = 0;
+    input->eof = 0;
+
+    // Regular files are mapped and parsed in place
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        input->eof = 1;
+        input->size = info.st_size;
+        if (input->size == 0)
         {
-            return 1;
+            return 0;
+        }
+        input->data = mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (input->data != MAP_FAILED)
+        {
+            madvise(input->data, input->size, MADV_SEQUENTIAL);
+            input->mapped = 1;
+            return 0;
         }
+        input->data = NULL;
+        input->size = 0;
+        input->eof = 0;
+    }
+
+    // Pipes and terminals are parsed a buffer at a time, so memory stays
+    // fixed however much input arrives
+    input->data = malloc(INPUT_BUFFER_SIZE);
+    if (input->data == NULL)
+    {
+        fprintf(stderr, "Out of memory reading input\n");
+        return 1;
+    }
+    input->capacity = INPUT_BUFFER_SIZE;
+    return 0;
+}
 
-        // Mark digit as seen, update the mask
-        digitMask |= digitBit;
+// Moves the unparsed bytes from keep onwards to the front of the buffer,
+// then reads more after them. Sets eof once read returns 0.
+static int refillInput(Input *input, const char *keep)
+{
+    size_t tail = input->data + input->size - keep;
+    memmove(input->data, keep, tail);
+    input->size = tail;
 
-        // Increment to next digit
-        num /= 10;
+    ssize_t got = read(input->fd, input->data + input->size, input->capacity - input->size);
+    if (got < 0)
+    {
+        perror("read");
+        return 1;
     }
+    input->eof = got == 0;
+    input->size += got;
+    return 0;
+}
 
+// End of the bytes that can be parsed now: everything at the end of input,
+// otherwise up to the last whitespace so no number is cut in two
+static const char *parseableEnd(const Input *input)
+{
+    const char *end = input->data + input->size;
+
+    if (input->eof)
+    {
+        return end;
+    }
+    while (end > input->data && end[-1] != ' ' && end[-1] != '\t' && end[-1] != '\n' && end[-1] != '\r')
+    {
+        end--;
+    }
+    return end;
+}
+
+static void freeInput(Input *input)
+{
+    if (input->mapped)
+    {
+        munmap(input->data, input->size);
+    }
+    else
+    {
+        free(input->data);
+    }
+}
+
+// Returns 0, or 1 if stdout did not take the buffered output
+static int flushOutput(Output *output)
+{
+    size_t written = fwrite(output->data, 1, output->used, stdout);
+    int failed = written != output->used || ferror(stdout);
+    output->used = 0;
+    return failed;
+}
+
+// Appends value and a newline, formatting the digits by hand. Returns
+// non-zero if making room failed to write the earlier output.
+static int writeCount(Output *output, int64_t value)
+{
+    // Longest line: 20 characters of INT64_MIN plus the newline
+    if (output->used + 21 > OUTPUT_BUFFER_SIZE && flushOutput(output) != 0)
+    {
+        return 1;
+    }
+
+    char digits[20];
+    int length = 0;
+    uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    do
+    {
+        digits[length++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    char *out = output->data + output->used;
+    if (value < 0)
+    {
+        *out++ = '-';
+    }
+    while (length > 0)
+    {
+        *out++ = digits[--length];
+    }
+    *out++ = '\n';
+    output->used = out - output->data;
     return 0;
 }
 
-int getCount(int floor, int ceiling)
+// Parses the next integer at *cursor, skipping leading whitespace.
+// Returns 1 on success, 0 at the end of input, -1 on malformed input.
+static int parseNumber(const char **cursor, const char *end, int64_t *value)
 {
-    int count = 0;
+    const char *p = *cursor;
 
-    for (int i = floor; i <= ceiling; i++)
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
     {
-        count += hasRepeatingDigits(i);
+        p++;
+    }
+    if (p == end)
+    {
+        *cursor = p;
+        return 0;
     }
 
-    return count;
+    int negative = 0;
+    if (*p == '-' || *p == '+')
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    // Accumulate the magnitude unsigned so INT64_MIN parses too
+    const char *start = p;
+    uint64_t magnitude = 0;
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        unsigned digit = *p - '0';
+        if (magnitude > (limit - digit) / 10)
+        {
+            return -1;
+        }
+        magnitude = magnitude * 10 + digit;
+        p++;
+    }
+    if (p == start || (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r'))
+    {
+        return -1;
+    }
+
+    *value = negative ? (int64_t)-magnitude : (int64_t)magnitude;
+    *cursor = p;
+    return 1;
+}
+
+// Line number of position p, for error messages
+static long lineOf(const char *data, const char *p)
+{
+    long line = 1;
+
+    for (const char *c = data; c < p; c++)
+    {
+        line += *c == '\n';
+    }
+
+    return line;
+}
+
+static int runBatch(const char *path)
+{
+    int fd = STDIN_FILENO;
+    if (path != NULL && strcmp(path, "-") != 0)
+    {
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            perror(path);
+            return 1;
+        }
+    }
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Input input;
+    Output *output = malloc(sizeof(Output));
+    int failed = output == NULL;
+    if (failed)
+    {
+        fprintf(stderr, "Out of memory\n");
+    }
+    else
+    {
+        failed = openInput(&input, fd);
+    }
+    if (failed)
+    {
+        free(output);
+        if (fd != STDIN_FILENO)
+        {
+            close(fd);
+        }
+        return 1;
+    }
+    output->used = 0;
+
+    // A pair may straddle two buffers, so its floor waits in pair[0]
+    int64_t pair[2];
+    int have = 0;
+    long line = 1;
+    long queries = 0;
+    while (!failed)
+    {
+        const char *cursor = input.data;
+        const char *end = parseableEnd(&input);
+        int status;
+        while ((status = parseNumber(&cursor, end, &pair[have])) > 0)
+        {
+            if (++have == 2)
+            {
+                if (writeCount(output, getCount(pair[0], pair[1])) != 0)
+                {
+                    failed = 1;
+                    break;
+                }
+                queries++;
+                have = 0;
+            }
+        }
+        if (failed)
+        {
+            break;
+        }
+
+        // Lines before cursor are done with; the rest is carried over.
+        // A full buffer with nothing parseable holds no valid number.
+        line += lineOf(input.data, cursor) - 1;
+        if (status < 0 || (input.eof && have > 0) ||
+            (!input.eof && cursor == input.data && input.size == input.capacity))
+        {
+            fprintf(stderr, "Invalid floor/ceiling pair on line %ld\n", line);
+            failed = 1;
+            break;
+        }
+        if (input.eof)
+        {
+            break;
+        }
+        if (refillInput(&input, cursor) != 0)
+        {
+            failed = 1;
+        }
+    }
+    if (fd != STDIN_FILENO)
+    {
+        close(fd);
+    }
+    if (flushOutput(output) != 0 || fflush(stdout) != 0)
+    {
+        perror("stdout");
+        failed = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "Answered %ld queries in %.3f s (%.0f queries/sec)\n", queries, seconds,
+            seconds > 0 ? queries / seconds : 0.0);
+
+    free(output);
+    freeInput(&input);
+    return failed;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    int floor = 0;
-    int ceiling = 100;
+    if (argc > 1)
+    {
+        if (strcmp(argv[1], "--batch") == 0 && argc <= 3)
+        {
+            return runBatch(argc == 3 ? argv[2] : NULL);
+        }
+        fprintf(stderr, "Usage: %s [--batch [file]]\n", argv[0]);
+        return 1;
+    }
+
+    int64_t floor = 0;
+    int64_t ceiling = 100;
 
     // Get floor from stdin
     printf("Check repeating digits floor: ");
-    if (scanf("%d", &floor) != 1)
+    if (scanf("%" SCNd64, &floor) != 1)
     {
         printf("Invalid input for floor\n");
         return 1;
@@ -66,14 +369,14 @@ int main()
 
     // Get ceiling from stdin
     printf("Check repeating digits ceiling: ");
-    if (scanf("%d", &ceiling) != 1)
+    if (scanf("%" SCNd64, &ceiling) != 1)
     {
         printf("Invalid input for ceiling\n");
         return 1;
     }
 
     // Call getCount and print the result
-    printf("Between %i and %i (inclusive) there are %i numbers with repeating digits!\n", floor, ceiling, getCount(floor, ceiling));
+    printf("Between %" PRId64 " and %" PRId64 " (inclusive) there are %" PRId64 " numbers with repeating digits!\n", floor, ceiling, getCount(floor, ceiling));
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,147 @@
+#include "repeatingDigits.h"
+
+// Check if a number has repeating digits using a bitmask
+int hasRepeatingDigits(int64_t num)
+{
+    // Initialize bitmask
+    // Visualization:
+    // 0000000000 : 9876543210
+    // 0000000100 : 2 is present
+    int digitMask = 0;
+
+    while (num > 0)
+    {
+        // Get current focus digit
+        int digit = num % 10;
+        // Create bitmask for digit via binary shift
+        int digitBit = 1 << digit;
+
+        // Check if digit has already been seen (bit is set in digitMask)
+        if (digitMask & digitBit)
+        {
+            return 1;
+        }
+
+        // Mark digit as seen, update the mask
+        digitMask |= digitBit;
+
+        // Increment to next digit
+        num /= 10;
+    }
+
+    return 0;
+}
+
+// Ways to fill `slots` positions from `available` unused digits, in order:
+// available! / (available - slots)!. Precomputed so a query never multiplies
+// or divides to get them.
+static const uint64_t arrangements[10][10] =
+{
+    {1, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+    {1, 1, 0, 0, 0, 0, 0, 0, 0, 0},
+    {1, 2, 2, 0, 0, 0, 0, 0, 0, 0},
+    {1, 3, 6, 6, 0, 0, 0, 0, 0, 0},
+    {1, 4, 12, 24, 24, 0, 0, 0, 0, 0},
+    {1, 5, 20, 60, 120, 120, 0, 0, 0, 0},
+    {1, 6, 30, 120, 360, 720, 720, 0, 0, 0},
+    {1, 7, 42, 210, 840, 2520, 5040, 5040, 0, 0},
+    {1, 8, 56, 336, 1680, 6720, 20160, 40320, 40320, 0},
+    {1, 9, 72, 504, 3024, 15120, 60480, 181440, 362880, 362880},
+};
+
+// Count of numbers with fewer than `length` digits whose digits are all
+// distinct: 0-9, then 9 * arrangements[9][len - 1] for each longer length
+static const uint64_t distinctShorterThan[11] =
+{
+    0, 0, 10, 91, 739, 5275, 32491, 168571, 712891, 2345851, 5611771,
+};
+
+// Count of numbers in [0, n] whose digits are all distinct. Walks the
+// digits of n from the most significant: numbers with fewer digits come
+// from the table, then at each position every smaller unused digit leaves
+// the remaining positions free to take any of the unused digits.
+static uint64_t countDistinctUpTo(uint64_t n)
+{
+    // The largest number with distinct digits; every longer number repeats
+    if (n > 9876543210ULL)
+    {
+        n = 9876543210ULL;
+    }
+
+    int digits[10];
+    int length = 0;
+    for (uint64_t rest = n; rest > 0; rest /= 10)
+    {
+        digits[length++] = rest % 10;
+    }
+    if (length <= 1)
+    {
+        return n + 1;
+    }
+
+    uint64_t count = distinctShorterThan[length];
+    int usedMask = 0;
+    for (int pos = length - 1; pos >= 0; pos--)
+    {
+        int digit = digits[pos];
+        int placed = length - 1 - pos;
+
+        // Unused digits below this one; no leading zero
+        int smaller = digit - __builtin_popcount(usedMask & ((1 << digit) - 1));
+        if (placed == 0)
+        {
+            smaller--;
+        }
+        count += smaller * arrangements[9 - placed][pos];
+
+        // n's own prefix already repeats: nothing further matches it
+        if (usedMask & (1 << digit))
+        {
+            return count;
+        }
+        usedMask |= 1 << digit;
+    }
+
+    // n itself has distinct digits
+    return count + 1;
+}
+
+// Count of numbers in [0, n] with a repeated digit
+static uint64_t countRepeatingUpTo(int64_t n)
+{
+    if (n < 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)n + 1 - countDistinctUpTo((uint64_t)n);
+}
+
+int64_t getCount(int64_t floor, int64_t ceiling)
+{
+    if (ceiling < floor)
+    {
+        return 0;
+    }
+
+    uint64_t below = floor > 0 ? countRepeatingUpTo(floor - 1) : 0;
+    return (int64_t)(countRepeatingUpTo(ceiling) - below);
+}
+
+int64_t getCountBrute(int64_t floor, int64_t ceiling)
+{
+    int64_t count = 0;
+
+    for (int64_t i = floor; i <= ceiling; i++)
+    {
+        count += hasRepeatingDigits(i);
+
+        // Stop before i++ overflows at the top of the range
+        if (i == INT64_MAX)
+        {
+            break;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,19 @@
+#ifndef REPEATING_DIGITS_H
+#define REPEATING_DIGITS_H
+
+#include <stdint.h>
+
+// Whether any decimal digit of num appears more than once. Zero and
+// negative numbers have no repeats.
+int hasRepeatingDigits(int64_t num);
+
+// Count of numbers in [floor, ceiling] (inclusive) with at least one
+// repeated digit, by counting digit patterns: O(digits), whatever the
+// width of the range. 0 if ceiling < floor.
+int64_t getCount(int64_t floor, int64_t ceiling);
+
+// Same answer by testing every number in the range; the reference
+// getCount is checked against
+int64_t getCountBrute(int64_t floor, int64_t ceiling);
+
+#endif
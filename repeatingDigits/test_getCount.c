@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "repeatingDigits.h"
+#include "classify.h"
+
+// Checks the digit-DP getCount against the brute-force loop, and the bulk
+// classifiers against hasRepeatingDigits
+
+static int failures = 0;
+
+void printTestResult(const char *description, int passed)
+{
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+    if (!passed)
+    {
+        failures++;
+    }
+}
+
+static uint64_t nextRand(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Random number of random length, so every digit count is covered
+static int64_t randomBound(uint64_t *state)
+{
+    int digits = 1 + nextRand(state) % 19;
+    uint64_t limit = 1;
+    for (int i = 0; i < digits; i++)
+    {
+        limit *= 10;
+    }
+    return (int64_t)(nextRand(state) % limit);
+}
+
+// Compares the two on ranges of width up to maxWidth starting at random
+// bounds; returns how many disagreed
+static int compareRandomRanges(uint64_t *state, int ranges, int64_t maxWidth)
+{
+    int mismatches = 0;
+
+    for (int r = 0; r < ranges; r++)
+    {
+        int64_t floor = randomBound(state);
+        int64_t width = nextRand(state) % (maxWidth + 1);
+        int64_t ceiling = floor > INT64_MAX - width ? INT64_MAX : floor + width;
+
+        if (getCount(floor, ceiling) != getCountBrute(floor, ceiling))
+        {
+            printf("  mismatch on [%" PRId64 ", %" PRId64 "]\n", floor, ceiling);
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+// Values of every length plus the edges the vector kernels special-case
+static void fillClassifyValues(uint64_t *state, uint32_t *values32, int64_t *values64, size_t count)
+{
+    const int64_t edges[] = {0, 1, 9, 10, 11, 100, 99999, 100000, 100001, 1000000, 9876543210LL,
+                             9876543211LL, 1023456789LL, 4294967295LL, -1, -11, INT64_MIN, INT64_MAX};
+    const size_t numEdges = sizeof(edges) / sizeof(edges[0]);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i % 7 == 0)
+        {
+            values32[i] = (uint32_t)edges[(i / 7) % numEdges];
+            values64[i] = edges[(i / 7) % numEdges];
+        }
+        else
+        {
+            values32[i] = (uint32_t)(nextRand(state) >> (nextRand(state) % 32));
+            // Half within the ten-digit range the 64-bit kernel splits
+            values64[i] = i % 2 ? (int64_t)(nextRand(state) % 10000000000ULL)
+                                : (int64_t)nextRand(state) >> (nextRand(state) % 64);
+        }
+    }
+}
+
+// Returns how many values of the bitmap disagree with hasRepeatingDigits,
+// counting any stray bit past the end of the values as one more
+static int checkBitmap(const uint64_t *bitmap, const uint32_t *values32, const int64_t *values64, size_t count)
+{
+    int mismatches = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int expected = values64 != NULL ? hasRepeatingDigits(values64[i]) : hasRepeatingDigits(values32[i]);
+        mismatches += (int)((bitmap[i / 64] >> (i % 64)) & 1) != expected;
+    }
+    if (count % 64 != 0 && bitmap[count / 64] >> (count % 64) != 0)
+    {
+        mismatches++;
+    }
+
+    return mismatches;
+}
+
+static void testClassify(uint64_t *state)
+{
+    const size_t sizes[] = {1, 7, 63, 64, 65, 1000, 300001};
+    const size_t largest = 300001;
+    uint32_t *values32 = malloc(largest * sizeof(uint32_t));
+    int64_t *values64 = malloc(largest * sizeof(int64_t));
+    uint64_t *bitmap = malloc(classifyBitmapWords(largest) * sizeof(uint64_t));
+    ThreadPool *pool = tp_create(3, 64);
+    if (values32 == NULL || values64 == NULL || bitmap == NULL || pool == NULL)
+    {
+        printTestResult("Allocating classifier buffers", 0);
+        return;
+    }
+    fillClassifyValues(state, values32, values64, largest);
+
+    const ClassifyKernel *kernels;
+    int numKernels = classifyKernels(&kernels);
+    char description[128];
+
+    for (int k = 0; k < numKernels; k++)
+    {
+        int mismatches32 = 0;
+        int mismatches64 = 0;
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            // Garbage in the bitmap must not survive
+            memset(bitmap, 0xA5, classifyBitmapWords(sizes[s]) * sizeof(uint64_t));
+            kernels[k].classify32(values32, sizes[s], bitmap);
+            mismatches32 += checkBitmap(bitmap, values32, NULL, sizes[s]);
+
+            memset(bitmap, 0xA5, classifyBitmapWords(sizes[s]) * sizeof(uint64_t));
+            kernels[k].classify64(values64, sizes[s], bitmap);
+            mismatches64 += checkBitmap(bitmap, NULL, values64, sizes[s]);
+        }
+        sprintf(description, "%s kernel: %d 32-bit and %d 64-bit mismatches", kernels[k].name, mismatches32,
+                mismatches64);
+        printTestResult(description, mismatches32 == 0 && mismatches64 == 0);
+    }
+
+    memset(bitmap, 0xA5, classifyBitmapWords(largest) * sizeof(uint64_t));
+    classifyRepeating32(values32, largest, bitmap, pool);
+    int mismatches = checkBitmap(bitmap, values32, NULL, largest);
+    memset(bitmap, 0xA5, classifyBitmapWords(largest) * sizeof(uint64_t));
+    classifyRepeating64(values64, largest, bitmap, pool);
+    mismatches += checkBitmap(bitmap, NULL, values64, largest);
+    sprintf(description, "Split across 3 threads: %d mismatches", mismatches);
+    printTestResult(description, mismatches == 0);
+
+    tp_destroy(pool);
+    free(bitmap);
+    free(values64);
+    free(values32);
+}
+
+int main()
+{
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    char description[128];
+
+    // Every prefix [0, n] up to 10^6, one brute-force pass
+    int64_t running = 0;
+    int prefixMismatches = 0;
+    for (int64_t n = 0; n <= 1000000; n++)
+    {
+        running += hasRepeatingDigits(n);
+        if (getCount(0, n) != running)
+        {
+            prefixMismatches++;
+        }
+    }
+    sprintf(description, "All prefixes [0, n] for n <= 10^6: %d mismatches", prefixMismatches);
+    printTestResult(description, prefixMismatches == 0);
+
+    int mismatches = compareRandomRanges(&state, 20000, 1000);
+    sprintf(description, "20000 random ranges of width <= 1000: %d mismatches", mismatches);
+    printTestResult(description, mismatches == 0);
+
+    mismatches = compareRandomRanges(&state, 200, 1000000);
+    sprintf(description, "200 random ranges of width <= 10^6: %d mismatches", mismatches);
+    printTestResult(description, mismatches == 0);
+
+    // Around the largest distinct-digit number and the top of the range
+    const int64_t edges[] = {9876543210LL, 10000000000LL, 1023456789LL, INT64_MAX - 500};
+    mismatches = 0;
+    for (int e = 0; e < 4; e++)
+    {
+        for (int64_t floor = edges[e] - 100; floor <= edges[e] + 100; floor += 7)
+        {
+            int64_t ceiling = floor > INT64_MAX - 400 ? INT64_MAX : floor + 400;
+            mismatches += getCount(floor, ceiling) != getCountBrute(floor, ceiling);
+        }
+    }
+    sprintf(description, "Ranges around 9876543210, 10^10, 1023456789 and INT64_MAX: %d mismatches", mismatches);
+    printTestResult(description, mismatches == 0);
+
+    // Negative numbers never repeat; empty ranges count nothing
+    printTestResult("Range [-1000, 1000] counts as [0, 1000]", getCount(-1000, 1000) == getCountBrute(0, 1000));
+    printTestResult("Range [INT64_MIN, -1] is 0", getCount(INT64_MIN, -1) == 0);
+    printTestResult("Ceiling below floor is 0", getCount(100, 99) == 0);
+
+    // Every number above 9876543210 repeats; 8877691 numbers in [0, 9876543210] do not
+    printTestResult("Range [0, INT64_MAX] is INT64_MAX + 1 - 8877691",
+                    (uint64_t)getCount(0, INT64_MAX) == (uint64_t)INT64_MAX + 1 - 8877691);
+
+    testClassify(&state);
+
+    printf("\n%s\n", failures == 0 ? "All tests passed" : "Some tests FAILED");
+    return failures == 0 ? 0 : 1;
+}
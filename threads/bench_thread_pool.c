@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "thread_pool.h"
+
+// Cost of handing a small task to another thread and getting its result
+// back: a fresh pthread per task (create + join, result malloc'd by the
+// thread as thread_template.c used to) against the pool. Pool rows: one
+// task at a time where tp_wait may run the task itself, one at a time
+// always handed to a worker (wakeup latency), and in batches (dispatch
+// throughput).
+//
+// Usage: bench_thread_pool [tasks] [threads]
+
+typedef struct {
+    int x;
+    int y;
+} Result;
+
+static void *malloc_task(void *arg) {
+    Result *r = malloc(sizeof(Result));
+    r->x = (int)(long)arg;
+    r->y = 2;
+    return r;
+}
+
+static void *pool_task(void *arg) {
+    Result *r = arg;
+    r->y = r->x + 1;
+    return r;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    const int tasks = argc > 1 ? atoi(argv[1]) : 20000;
+    const int num_threads = argc > 2 ? atoi(argv[2]) : 4;
+    const int batch = 64;
+    long check = 0;
+
+    printf("%d tasks, pool of %d threads\n", tasks, num_threads);
+    printf("%-28s %12s %14s\n", "dispatch", "ns/task", "tasks/s");
+
+    double start = now_ns();
+    for (int i = 0; i < tasks; i++) {
+        pthread_t t;
+        Result *r;
+        pthread_create(&t, NULL, malloc_task, (void *)(long)i);
+        pthread_join(t, (void **)&r);
+        check += r->x;
+        free(r);
+    }
+    double ns = (now_ns() - start) / tasks;
+    printf("%-28s %12.0f %14.0f\n", "pthread_create + join", ns, 1e9 / ns);
+
+    ThreadPool *pool = tp_create(num_threads, 256);
+    if (pool == NULL) return 1;
+
+    Result one;
+    TpFuture f;
+    start = now_ns();
+    for (int i = 0; i < tasks; i++) {
+        one.x = i;
+        tp_submit(pool, &f, pool_task, &one);
+        check += ((Result *)tp_wait(pool, &f))->y;
+    }
+    ns = (now_ns() - start) / tasks;
+    printf("%-28s %12.0f %14.0f\n", "pool submit + wait", ns, 1e9 / ns);
+
+    start = now_ns();
+    for (int i = 0; i < tasks; i++) {
+        one.x = i;
+        tp_submit(pool, &f, pool_task, &one);
+        while (!tp_done(&f)) {
+            sched_yield();
+        }
+        check += ((Result *)tp_wait(pool, &f))->y;
+    }
+    ns = (now_ns() - start) / tasks;
+    printf("%-28s %12.0f %14.0f\n", "pool, handed to a worker", ns, 1e9 / ns);
+
+    Result results[64];
+    TpFuture futures[64];
+    start = now_ns();
+    for (int done = 0; done < tasks; done += batch) {
+        for (int i = 0; i < batch; i++) {
+            results[i].x = done + i;
+            tp_submit(pool, &futures[i], pool_task, &results[i]);
+        }
+        for (int i = 0; i < batch; i++) {
+            check += ((Result *)tp_wait(pool, &futures[i]))->y;
+        }
+    }
+    ns = (now_ns() - start) / (double)((tasks + batch - 1) / batch * batch);
+    char label[40];
+    snprintf(label, sizeof(label), "pool, batches of %d", batch);
+    printf("%-28s %12.0f %14.0f\n", label, ns, 1e9 / ns);
+
+    tp_destroy(pool);
+    (void)check;
+    return 0;
+}
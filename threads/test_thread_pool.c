@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+// Helper function to print test results
+void print_test_header(const char* test_name) {
+    printf("\n========================================\n");
+    printf("TEST: %s\n", test_name);
+    printf("========================================\n");
+}
+
+void print_test_result(const char* description, int passed) {
+    printf("[%s] %s\n", passed ? "PASS" : "FAIL", description);
+}
+
+typedef struct {
+    long value;
+    int runs;
+} Task;
+
+static void* square(void* arg) {
+    Task* task = arg;
+    __atomic_add_fetch(&task->runs, 1, __ATOMIC_RELAXED);
+    task->value = task->value * task->value;
+    return task;
+}
+
+// Every job runs exactly once and its future returns its own result, with
+// the queue much smaller than the number of jobs in flight
+void test_futures() {
+    print_test_header("Futures Return Each Job's Result Once");
+
+    const int n = 10000;
+    ThreadPool* pool = tp_create(4, 8);
+    Task* tasks = malloc(n * sizeof(Task));
+    TpFuture* futures = malloc(n * sizeof(TpFuture));
+    if (pool == NULL || tasks == NULL || futures == NULL) {
+        printf("Failed to allocate\n");
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        tasks[i] = (Task){i, 0};
+        tp_submit(pool, &futures[i], square, &tasks[i]);
+    }
+    int wrong = 0;
+    for (int i = 0; i < n; i++) {
+        Task* result = tp_wait(pool, &futures[i]);
+        if (result != &tasks[i] || result->value != (long)i * i || result->runs != 1 || !tp_done(&futures[i])) {
+            wrong++;
+        }
+    }
+
+    char description[96];
+    sprintf(description, "%d jobs through a queue of 8: %d wrong results", n, wrong);
+    print_test_result(description, wrong == 0);
+    tp_destroy(pool);
+    free(tasks);
+    free(futures);
+}
+
+typedef struct {
+    ThreadPool* pool;
+    long sum;
+} Producer;
+
+static void* identity(void* arg) {
+    return arg;
+}
+
+static void* produce(void* arg) {
+    Producer* p = arg;
+    TpFuture futures[64];
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 64; i++) {
+            tp_submit(p->pool, &futures[i], identity, (void*)(long)(round * 64 + i + 1));
+        }
+        for (int i = 0; i < 64; i++) {
+            p->sum += (long)tp_wait(p->pool, &futures[i]);
+        }
+    }
+    return NULL;
+}
+
+// Several threads submitting and waiting at once: nothing lost, nothing
+// delivered twice
+void test_many_producers() {
+    print_test_header("Concurrent Producers");
+
+    const int num_producers = 4;
+    const long per_producer = 200 * 64;
+    ThreadPool* pool = tp_create(3, 32);
+    pthread_t threads[4];
+    Producer producers[4];
+    if (pool == NULL) return;
+
+    for (int i = 0; i < num_producers; i++) {
+        producers[i] = (Producer){pool, 0};
+        pthread_create(&threads[i], NULL, produce, &producers[i]);
+    }
+    int ok = 1;
+    for (int i = 0; i < num_producers; i++) {
+        pthread_join(threads[i], NULL);
+        ok &= producers[i].sum == per_producer * (per_producer + 1) / 2;
+    }
+
+    char description[96];
+    sprintf(description, "%d producers x %ld jobs, every sum correct", num_producers, per_producer);
+    print_test_result(description, ok);
+    tp_destroy(pool);
+}
+
+// With no workers the caller runs each job inside tp_submit
+void test_no_workers() {
+    print_test_header("Pool Without Workers");
+
+    ThreadPool* pool = tp_create(0, 4);
+    if (pool == NULL) return;
+    Task task = {7, 0};
+    TpFuture f;
+    tp_submit(pool, &f, square, &task);
+    print_test_result("Job runs on the submitting thread", tp_done(&f) && task.value == 49);
+    print_test_result("tp_wait returns its result", tp_wait(pool, &f) == &task);
+    tp_destroy(pool);
+}
+
+int main(void) {
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   THREAD POOL TEST SUITE               ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+
+    test_futures();
+    test_many_producers();
+    test_no_workers();
+
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║   ALL TESTS COMPLETED                  ║\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("\n");
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "thread_pool.h"
+
+#define CACHE_LINE 64
+
+// One slot of the queue. `seq` says whose turn the slot is: equal to the
+// enqueue position when it is free for that producer, position + 1 once it
+// holds a job for the consumer at that position (Vyukov's bounded MPMC
+// queue).
+typedef struct {
+    size_t seq;
+    TpFuture *job;
+} TpCell;
+
+struct ThreadPool {
+    TpCell *cells;
+    size_t mask;
+    // Producers and consumers each hammer their own counter; keep them on
+    // separate cache lines
+    char pad0[CACHE_LINE];
+    size_t enqueue_pos;
+    char pad1[CACHE_LINE - sizeof(size_t)];
+    size_t dequeue_pos;
+    char pad2[CACHE_LINE - sizeof(size_t)];
+
+    sem_t jobs; // posted once per enqueued job, workers sleep on it
+    pthread_t *threads;
+    int num_threads;
+    int stop;
+
+    // Threads blocked in tp_wait; workers only touch the mutex when > 0
+    int waiters;
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+};
+
+static int enqueue(ThreadPool *pool, TpFuture *job) {
+    size_t pos = __atomic_load_n(&pool->enqueue_pos, __ATOMIC_RELAXED);
+    TpCell *cell;
+    while (1) {
+        cell = &pool->cells[pos & pool->mask];
+        const size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&pool->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0; // full
+        } else {
+            pos = __atomic_load_n(&pool->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->job = job;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static TpFuture *dequeue(ThreadPool *pool) {
+    size_t pos = __atomic_load_n(&pool->dequeue_pos, __ATOMIC_RELAXED);
+    TpCell *cell;
+    while (1) {
+        cell = &pool->cells[pos & pool->mask];
+        const size_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&pool->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL; // empty
+        } else {
+            pos = __atomic_load_n(&pool->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    TpFuture *job = cell->job;
+    __atomic_store_n(&cell->seq, pos + pool->mask + 1, __ATOMIC_RELEASE);
+    return job;
+}
+
+static void run_job(ThreadPool *pool, TpFuture *job) {
+    job->result = job->fn(job->arg);
+    // Sequentially consistent, paired with tp_wait: either the waiter sees
+    // `done` before sleeping or this sees the waiter and wakes it
+    __atomic_store_n(&job->done, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_broadcast(&pool->finished);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void *worker(void *arg) {
+    ThreadPool *pool = arg;
+    while (1) {
+        while (sem_wait(&pool->jobs) != 0 && errno == EINTR) {
+        }
+        // Waiters that help may already have taken the job this post was
+        // for, so an empty queue is not an error
+        TpFuture *job = dequeue(pool);
+        if (job != NULL) {
+            run_job(pool, job);
+        } else if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+ThreadPool *tp_create(int num_threads, int queue_capacity) {
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        return NULL;
+    }
+
+    size_t capacity = 2;
+    while (capacity < (size_t)queue_capacity) {
+        capacity <<= 1;
+    }
+    pool->cells = malloc(capacity * sizeof(TpCell));
+    pool->threads = malloc((size_t)(num_threads > 0 ? num_threads : 1) * sizeof(pthread_t));
+    if (pool->cells == NULL || pool->threads == NULL || sem_init(&pool->jobs, 0, 0) != 0) {
+        fprintf(stderr, "Error: memory allocation failed\n");
+        free(pool->cells);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        pool->cells[i].seq = i;
+    }
+    pool->mask = capacity - 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            fprintf(stderr, "Error: cannot start worker thread %d\n", i);
+            break;
+        }
+        pool->num_threads++;
+    }
+    return pool;
+}
+
+void tp_destroy(ThreadPool *pool) {
+    if (pool == NULL) return;
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < pool->num_threads; i++) {
+        sem_post(&pool->jobs);
+    }
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    // Anything still queued ran on no worker; finish it here
+    TpFuture *job;
+    while ((job = dequeue(pool)) != NULL) {
+        run_job(pool, job);
+    }
+    sem_destroy(&pool->jobs);
+    pthread_cond_destroy(&pool->finished);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->cells);
+    free(pool->threads);
+    free(pool);
+}
+
+int tp_num_threads(const ThreadPool *pool) {
+    return pool->num_threads;
+}
+
+void tp_submit(ThreadPool *pool, TpFuture *future, TpFn fn, void *arg) {
+    future->fn = fn;
+    future->arg = arg;
+    future->result = NULL;
+    future->done = 0;
+    // A pool without workers runs everything on the caller
+    if (pool->num_threads == 0) {
+        run_job(pool, future);
+        return;
+    }
+    while (!enqueue(pool, future)) {
+        TpFuture *job = dequeue(pool);
+        if (job != NULL) {
+            run_job(pool, job);
+        }
+    }
+    sem_post(&pool->jobs);
+}
+
+int tp_done(const TpFuture *future) {
+    return __atomic_load_n(&future->done, __ATOMIC_ACQUIRE);
+}
+
+void *tp_wait(ThreadPool *pool, TpFuture *future) {
+    while (!__atomic_load_n(&future->done, __ATOMIC_ACQUIRE)) {
+        TpFuture *job = dequeue(pool);
+        if (job != NULL) {
+            run_job(pool, job);
+            continue;
+        }
+
+        // Nothing left to help with: the job is running on a worker
+        __atomic_add_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_lock(&pool->lock);
+        while (!__atomic_load_n(&future->done, __ATOMIC_SEQ_CST)) {
+            pthread_cond_wait(&pool->finished, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        __atomic_sub_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+    return future->result;
+}
@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fixed set of worker threads fed from a bounded lock-free MPMC queue.
+// Submitting a job costs one enqueue and one sem_post instead of a
+// pthread_create/pthread_join pair, and results come back through
+// caller-owned futures, so nothing is allocated per job.
+//
+//   TpFuture f;
+//   tp_submit(pool, &f, work, &args);
+//   ...
+//   result = tp_wait(pool, &f);
+
+typedef void *(*TpFn)(void *arg);
+
+// Filled in by tp_submit; must stay alive until tp_wait returns. The
+// fields are the pool's, read them through tp_wait / tp_done.
+typedef struct {
+    TpFn fn;
+    void *arg;
+    void *result;
+    int done;
+} TpFuture;
+
+typedef struct ThreadPool ThreadPool;
+
+// `queue_capacity` is rounded up to a power of two. Returns NULL on failure.
+ThreadPool *tp_create(int num_threads, int queue_capacity);
+// Waits for the workers to finish queued jobs and stops them
+void tp_destroy(ThreadPool *pool);
+int tp_num_threads(const ThreadPool *pool);
+
+// Queues fn(arg). If the queue is full the caller runs queued jobs itself
+// until there is room, so this never fails and never blocks for long.
+void tp_submit(ThreadPool *pool, TpFuture *future, TpFn fn, void *arg);
+// Whether the job has finished, without waiting
+int tp_done(const TpFuture *future);
+// Waits for the job and returns fn's result. While the job is still queued
+// the caller runs queued jobs instead of sleeping.
+void *tp_wait(ThreadPool *pool, TpFuture *future);
+
+#endif
@@ -1,24 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <pthread.h>
+#include "thread_pool.h"
 
 typedef struct {int a; int b;} myarg_t;
 typedef struct {int x; int y;} myret_t;
+// Arguments and result travel together, so the worker needs no malloc
+typedef struct {myarg_t args; myret_t rvals;} myjob_t;
 
 void *mythread(void *arg) {
-	myret_t *rvals = malloc(sizeof(myret_t));
-	rvals->x = 1;
-	rvals->y = 2;
-	return (void *) rvals;
+	myjob_t *job = arg;
+	job->rvals.x = 1;
+	job->rvals.y = 2;
+	return &job->rvals;
 }
 
 int main(int argc, char *argv[]) {
-	pthread_t p;
-	myret_t *rvals;
-	myarg_t args = {10, 20};
-	pthread_create(&p, NULL, mythread, &args);
-	pthread_join(p, (void **) &rvals);
+	ThreadPool *pool = tp_create(2, 16);
+	if (pool == NULL) {
+		return 1;
+	}
+	TpFuture f;
+	myjob_t job = {{10, 20}, {0, 0}};
+	tp_submit(pool, &f, mythread, &job);
+	myret_t *rvals = tp_wait(pool, &f);
 	printf("Returned %d %d\n", rvals->x, rvals->y);
-	free(rvals);
+	tp_destroy(pool);
 	return 0;
 }